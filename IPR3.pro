@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,15 +9,54 @@ DEFINES += PROJECT_PATH=\"\\\"$${_PRO_FILE_PWD_}/\\\"\"
 SOURCES += \
     src/frame.cpp \
     src/framecomboboxmodel.cpp \
+    src/framemodel.cpp \
+    src/framemodelclient.cpp \
+    src/framemodeldiff.cpp \
+    src/framemodelfile.cpp \
+    src/framemodelhistory.cpp \
+    src/framemodelimporter.cpp \
+    src/framemodelloader.cpp \
+    src/framemodelprotocol.cpp \
+    src/framemodelserver.cpp \
+    src/framemodeltool.cpp \
+    src/framemodelvalidator.cpp \
     src/framemodelwidget.cpp \
+    src/framepool.cpp \
+    src/frameshardstore.cpp \
     src/main.cpp \
-    src/mainwindow.cpp
+    src/mainwindow.cpp \
+    src/profiler.cpp \
+    src/profilerwidget.cpp \
+    src/slotstringpool.cpp \
+    src/slottable.cpp
 
 HEADERS += \
+    src/contenthash.h \
     src/frame.h \
     src/framecomboboxmodel.h \
+    src/framehandle.h \
+    src/framemodel.h \
+    src/framemodelclient.h \
+    src/framemodeldiff.h \
+    src/framemodelfile.h \
+    src/framemodelhistory.h \
+    src/framemodelimporter.h \
+    src/framemodelloader.h \
+    src/framemodelprotocol.h \
+    src/framemodelserver.h \
+    src/framemodeltool.h \
+    src/framemodelvalidator.h \
     src/framemodelwidget.h \
-    src/mainwindow.h
+    src/framepool.h \
+    src/frameshardstore.h \
+    src/framesource.h \
+    src/mainwindow.h \
+    src/memoryusage.h \
+    src/profiler.h \
+    src/profilerwidget.h \
+    src/slotstringpool.h \
+    src/slottable.h \
+    src/spatialgrid.h
 
 FORMS += \
     src/mainwindow.ui
@@ -0,0 +1,43 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QString>
+
+// Детерминированные 64-битные хеши содержимого. В отличие от qHash, не зависят от случайного
+// затравочного значения процесса, поэтому хеши, посчитанные в разных запусках, можно сравнивать
+namespace ContentHash {
+    // Финализатор splitmix64
+    inline quint64 Mix(quint64 value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    // Зависит от порядка аргументов, в отличие от суммы хешей, которой объединяются элементы множеств
+    inline quint64 Combine(quint64 seed, quint64 value) {
+        return Mix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+    }
+
+    inline quint64 HashString(const QString& string) {
+        const auto* data = string.utf16();
+        const int size = string.size();
+        quint64 hash = Mix(0xcbf29ce484222325ull ^ static_cast<quint64>(size));
+        int index = 0;
+
+        // Символы UTF-16 обрабатываются по четыре за раз
+        for (; index + 4 <= size; index += 4) {
+            const quint64 chunk = quint64(data[index]) | quint64(data[index + 1]) << 16 | quint64(data[index + 2]) << 32 | quint64(data[index + 3]) << 48;
+            hash = Mix(hash ^ chunk) + 0x9e3779b97f4a7c15ull;
+        }
+
+        quint64 tail = 0;
+
+        for (int shift = 0; index < size; ++index, shift += 16) {
+            tail |= quint64(data[index]) << shift;
+        }
+
+        return Mix(hash ^ tail);
+    }
+}
+
+#endif // CONTENTHASH_H
@@ -1,6 +1,8 @@
 #include "frame.h"
+#include "contenthash.h"
+#include "profiler.h"
 
-Frame::Frame(QString name) : _name(std::move(name)), _infoText(_frameHint + _name + "\"")
+Frame::Frame(QString name) : _name(std::move(name))
 {
 }
 
@@ -8,12 +10,16 @@ const QString& Frame::GetName() const {
     return _name;
 }
 
-const QString& Frame::GetLongestFrameText() const {
-    return _longestSlotText.size() < _infoText.size() ? _infoText : _longestSlotText;
+QString Frame::GetLongestFrameText() const {
+    if (_longestSlotIndex < 0)
+        return GetInfoText();
+
+    const auto& longestSlot = *(_slots.begin() + _longestSlotIndex);
+    return GetSlotInfoTextLength(longestSlot) < _frameHint.size() + _name.size() + 1 ? GetInfoText() : GetSlotInfoText(longestSlot);
 }
 
-const QString& Frame::GetInfoText() const {
-    return _infoText;
+QString Frame::GetInfoText() const {
+    return _frameHint + _name + "\"";
 }
 
 const Frame::Slots& Frame::GetSlots() const {
@@ -37,9 +43,10 @@ QStringList Frame::GetAllSlotsWithValues(const QStringList& semanticSearchSlotVa
                 semanticSearchInfo.append("Слот \"").append(slotName).append("\" со значением \"").append(regularSlotValue).append('\"');
         }
 
-        void operator()(const Frame* slotFrame) {
-            if (semanticSearchSlotValues.contains(slotFrame->GetName()))
-                semanticSearchInfo.append("Слот \"Фрейм-ссылка\" со значением \"").append(slotFrame->GetName()).append('\"');
+        // Имя слота-фрейма совпадает с именем фрейма, на который он ссылается
+        void operator()(FrameHandle) {
+            if (semanticSearchSlotValues.contains(slotName))
+                semanticSearchInfo.append("Слот \"Фрейм-ссылка\" со значением \"").append(slotName).append('\"');
         }
     };
 
@@ -55,71 +62,131 @@ QStringList Frame::GetAllSlotsWithValues(const QStringList& semanticSearchSlotVa
 }
 
 bool Frame::Contains(const QString& slotName) const {
-    return _slots.find(slotName) != _slots.end();
+    return _slots.Find(slotName) != _slots.end();
+}
+
+quint64 Frame::GetContentHash() const {
+    return ContentHash::Combine(ContentHash::HashString(_name), _slotsHash);
 }
 
 void Frame::SetName(QString newName) {
     _name = std::move(newName);
-    _infoText = _frameHint + _name + "\"";
 }
 
 void Frame::AddSlot(QString slotName, QString slotValue) {
-    QString tmpLongestSlotText = slotName + " (" + slotValue + ")";
-
-    if (_longestSlotText.size() < tmpLongestSlotText.size())
-        _longestSlotText = std::move(tmpLongestSlotText);
-
-    _slots[std::move(slotName)] = std::move(slotValue);
+    const int oldSlotsCount = _slots.Size();
+    SubtractSlotHash(slotName);
+    _slotsHash += GetSlotHash(slotName, slotValue);
+    _slots.InsertOrAssign(std::move(slotName), std::move(slotValue));
+    UpdateLongestSlotText(oldSlotsCount);
 }
 
-void Frame::AddSlot(const Frame* slotFrame) {
-    QString tmpLongestSlotText = "Фрейм-ссылка (\"" + slotFrame->GetName() + "\")";
-
-    if (_longestSlotText.size() < tmpLongestSlotText.size())
-        _longestSlotText = std::move(tmpLongestSlotText);
-
-    _slots[slotFrame->GetName()] = slotFrame;
+void Frame::AddSlot(QString slotFrameName, FrameHandle slotFrameHandle) {
+    const int oldSlotsCount = _slots.Size();
+    SubtractSlotHash(slotFrameName);
+    _slotsHash += GetSlotHash(slotFrameName, slotFrameHandle);
+    _slots.InsertOrAssign(std::move(slotFrameName), slotFrameHandle);
+    UpdateLongestSlotText(oldSlotsCount);
 }
 
 void Frame::ReplaceSlotName(const QString& oldFrameName, QString newFrameName) {
-    auto node = _slots.extract(oldFrameName);
-    node.key() = std::move(newFrameName);
-    _slots.insert(std::move(node));
+    const auto& slotValue = qAsConst(_slots).At(oldFrameName);
+    const auto slotsHashDelta = GetSlotHash(newFrameName, slotValue) - GetSlotHash(oldFrameName, slotValue);
+
+    // Хеш меняется только после успешного переименования: SlotTable::Rename отказывает, если слот newFrameName уже есть
+    _slots.Rename(oldFrameName, std::move(newFrameName));
+    _slotsHash += slotsHashDelta;
     RecalculateLongestSlotText();
 }
 
 void Frame::ReplaceSlotValue(const QString& slotName, QString slotValue) {
     // В данном случае по slotName вернётся именно std::variant, хранящий в себе QString
-    _slots.at(slotName) = std::move(slotValue);
+    auto& oldSlotValue = _slots.At(slotName);
+
+    _slotsHash += GetSlotHash(slotName, slotValue) - GetSlotHash(slotName, oldSlotValue);
+    oldSlotValue = std::move(slotValue);
     RecalculateLongestSlotText();
 }
 
 void Frame::EraseSlot(const QString& slotName) {
-    _slots.erase(slotName);
+    SubtractSlotHash(slotName);
+    _slots.Erase(slotName);
     RecalculateLongestSlotText();
 }
 
+void Frame::BeginSlotsUpdate() {
+    _isUpdatingSlots = true;
+}
+
+void Frame::EndSlotsUpdate() {
+    _isUpdatingSlots = false;
+    RecalculateLongestSlotText();
+}
+
+QString Frame::GetSlotInfoText(const Slots::Slot& slot) {
+    if (std::holds_alternative<QString>(slot.value))
+        return slot.name + " (" + std::get<QString>(slot.value) + ")";
+    else
+        return _frameReferenceHint + slot.name + "\")";
+}
+
+int Frame::GetSlotInfoTextLength(const Slots::Slot& slot) {
+    // Длина подписи из GetSlotInfoText, вычисленная без построения самой строки
+    if (std::holds_alternative<QString>(slot.value))
+        return slot.name.size() + 2 + std::get<QString>(slot.value).size() + 1;
+    else
+        return _frameReferenceHint.size() + slot.name.size() + 2;
+}
+
+quint64 Frame::GetSlotHash(const QString& slotName, const SlotValue& slotValue) {
+    // Обычный слот и слот-фрейм с одинаковыми именем и текстом значения должны различаться
+    const auto slotValueHash = std::holds_alternative<QString>(slotValue) ? ContentHash::HashString(std::get<QString>(slotValue)) : 0x5f3759df5f3759dfull;
+    return ContentHash::Combine(ContentHash::HashString(slotName), slotValueHash);
+}
+
+void Frame::SubtractSlotHash(const QString& slotName) {
+    const auto& constSlots = _slots;
+    const auto slotIt = constSlots.Find(slotName);
+
+    if (slotIt != constSlots.end())
+        _slotsHash -= GetSlotHash(slotIt->name, slotIt->value);
+}
+
+void Frame::UpdateLongestSlotText(int oldSlotsCount) {
+    if (_isUpdatingSlots)
+        return;
+
+    // Если значение существующего слота было перезаписано, самый длинный слот мог стать короче
+    if (_slots.Size() == oldSlotsCount) {
+        RecalculateLongestSlotText();
+        return;
+    }
+
+    // Новый слот добавляется в конец, поэтому достаточно сравнить его с текущим самым длинным
+    const int newSlotIndex = _slots.Size() - 1;
+
+    if (_longestSlotIndex < 0 || GetSlotInfoTextLength(*(_slots.begin() + _longestSlotIndex)) < GetSlotInfoTextLength(*(_slots.begin() + newSlotIndex)))
+        _longestSlotIndex = newSlotIndex;
+}
+
 void Frame::RecalculateLongestSlotText() {
-    auto generateSlotInfoText = [](const std::pair<QString, std::variant<QString, const Frame*>>& frameSlot) -> QString {
-        if (std::holds_alternative<QString>(frameSlot.second))
-            return frameSlot.first + " (" + std::get<QString>(frameSlot.second) + ")";
-        else
-            return "Фрейм-ссылка (\"" + std::get<const Frame*>(frameSlot.second)->GetName() + "\")";
-    };
+    if (_isUpdatingSlots)
+        return;
+
+    PROFILE_SCOPE("Frame::RecalculateLongestSlotText");
+
+    _longestSlotIndex = -1;
+    int longestSlotInfoTextLength = -1;
+    int slotIndex = 0;
+
+    for (const auto& slot : qAsConst(_slots)) {
+        const int slotInfoTextLength = GetSlotInfoTextLength(slot);
+
+        if (longestSlotInfoTextLength < slotInfoTextLength) {
+            longestSlotInfoTextLength = slotInfoTextLength;
+            _longestSlotIndex = slotIndex;
+        }
 
-    auto longestSlotInfoTextIt = std::max_element(_slots.begin(), _slots.end(), [=]
-                                                 (const std::pair<QString, std::variant<QString, const Frame*>>& left,
-                                                  const std::pair<QString, std::variant<QString, const Frame*>>& right)
-    {
-        const auto leftSlotInfoText = generateSlotInfoText(left);
-        const auto rightSlotInfoText = generateSlotInfoText(right);
-        return leftSlotInfoText.size() < rightSlotInfoText.size();
-    });
-
-    if (longestSlotInfoTextIt != _slots.end()) {
-        if (std::holds_alternative<QString>(longestSlotInfoTextIt->second))
-            _longestSlotText = longestSlotInfoTextIt->first + " (" + std::get<QString>(longestSlotInfoTextIt->second) + ")";
-        else
-            _longestSlotText = "Фрейм-ссылка (\"" + std::get<const Frame*>(longestSlotInfoTextIt->second)->GetName() + "\")";
+        ++slotIndex;
     }
 }
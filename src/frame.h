@@ -1,40 +1,56 @@
 #ifndef FRAME_H
 #define FRAME_H
 
-#include <QHash>
-#include <QString>
-#include <variant>
+#include "slottable.h"
+#include <QStringList>
 
 class Frame {
 public:
     // [SlotName, Slot (обычный(его значение) / слот-фрейм)]
-    using SlotValue = std::variant<QString, const Frame*>;
-    using Slots = std::unordered_map<QString, SlotValue>;
+    using SlotValue = SlotTable::Value;
+    using Slots = SlotTable;
 
     Frame() = default;
     explicit Frame(QString name);
     const QString& GetName() const;
-    const QString& GetLongestFrameText() const;
-    const QString& GetInfoText() const;
+    QString GetLongestFrameText() const;
+    QString GetInfoText() const;
     const Slots& GetSlots() const;
     Slots& GetSlots();
     QStringList GetAllSlotsWithValues(const QStringList& semanticSearchSlotValues) const;
     bool Contains(const QString& slotName) const;
+    quint64 GetContentHash() const;
     void SetName(QString newName);
     void AddSlot(QString slotName, QString slotValue);
-    void AddSlot(const Frame* slotFrame);
+    void AddSlot(QString slotFrameName, FrameHandle slotFrameHandle);
     void ReplaceSlotName(const QString& oldFrameName, QString newFrameName);
     void ReplaceSlotValue(const QString& slotName, QString slotValue);
     void EraseSlot(const QString& slotName);
+    // Между BeginSlotsUpdate и EndSlotsUpdate самый длинный слот не отслеживается и пересчитывается
+    // один раз в EndSlotsUpdate: для пакетного добавления слотов, при котором фрейм не отображается
+    void BeginSlotsUpdate();
+    void EndSlotsUpdate();
+
+    static QString GetSlotInfoText(const Slots::Slot& slot);
 
 private:
     QString _name;
-    QString _longestSlotText;
-    QString _infoText;
     Slots _slots;
+    // Отображаемые строки фрейма не хранятся, а строятся по требованию: запоминается только
+    // индекс слота с самой длинной подписью
+    int _longestSlotIndex = -1;
+    // Сумма хешей слотов: не зависит от их порядка и поддерживается мутаторами без обхода всех слотов.
+    // FrameHandle слота-фрейма в хеш не входит, только имя, поэтому разрешение ссылок его не меняет
+    quint64 _slotsHash = 0;
+    bool _isUpdatingSlots = false;
 
     inline static const QString _frameHint = "Фрейм \"";
+    inline static const QString _frameReferenceHint = "Фрейм-ссылка (\"";
 
+    static int GetSlotInfoTextLength(const Slots::Slot& slot);
+    static quint64 GetSlotHash(const QString& slotName, const SlotValue& slotValue);
+    void SubtractSlotHash(const QString& slotName);
+    void UpdateLongestSlotText(int oldSlotsCount);
     void RecalculateLongestSlotText();
 };
 
@@ -1,45 +1,88 @@
 #include "framecomboboxmodel.h"
-#include "frame.h"
+#include "framemodel.h"
 
 FrameComboBoxModel::FrameComboBoxModel(QObject* parent) : QAbstractListModel(parent)
 {
 }
 
-void FrameComboBoxModel::AddFrame(const Frame* frame) {
+void FrameComboBoxModel::SetModel(const FrameModel* frameModel) {
+    if (_frameModel)
+        disconnect(_frameModel, nullptr, this, nullptr);
+
+    _frameModel = frameModel;
+    ResetFrames();
+
+    if (!_frameModel)
+        return;
+
+    connect(_frameModel, &FrameModel::FrameAdded, this, &FrameComboBoxModel::AddFrame);
+    connect(_frameModel, &FrameModel::FrameAboutToBeErased, this, &FrameComboBoxModel::EraseFrame);
+    connect(_frameModel, &FrameModel::ModelReset, this, &FrameComboBoxModel::ResetFrames);
+    connect(_frameModel, &FrameModel::BulkUpdateFinished, this, &FrameComboBoxModel::ResetFrames);
+    connect(_frameModel, &FrameModel::FrameRenamed, this, &FrameComboBoxModel::RenameFrame);
+}
+
+void FrameComboBoxModel::AddFrame(FrameHandle frameHandle) {
+    const auto& frameName = _frameModel->Get(frameHandle)->GetName();
+
+    if (_listedFrameNames.contains(frameName))
+        return;
+
     beginInsertRows(QModelIndex(), rowCount(),  rowCount());
-    _frames.insert(rowCount(), frame);
+    _frameNames.append(frameName);
+    _listedFrameNames.insert(frameName);
     endInsertRows();
 }
 
-void FrameComboBoxModel::EraseFrame(const Frame* frame) {
-    auto eraseIt = std::find(_frames.begin(), _frames.end(), frame);
-    removeRows(std::distance(_frames.begin(), eraseIt), 1);
+void FrameComboBoxModel::EraseFrame(FrameHandle frameHandle) {
+    const auto& frameName = _frameModel->Get(frameHandle)->GetName();
+
+    // Поиск строки линейный, но сигнал приходит только при удалении фрейма, а не при выгрузке шарда
+    if (_listedFrameNames.remove(frameName))
+        removeRows(_frameNames.indexOf(frameName), 1);
 }
 
 QVariant FrameComboBoxModel::data(const QModelIndex& index, int role) const {
-    if (!index.isValid() || index.row() < 0 ||  index.row()  >= _frames.size())
+    if (!index.isValid() || index.row() < 0 ||  index.row()  >= _frameNames.size())
             return QVariant();
 
     switch(role) {
         case Qt::DisplayRole:
-            return _frames[index.row()]->GetName();
+            return _frameNames[index.row()];
         default:
             return QVariant();
     }
 }
 
 int FrameComboBoxModel::rowCount(const QModelIndex&) const {
-    return _frames.size();
+    return _frameNames.size();
 }
 
 bool FrameComboBoxModel::removeRows(int row, int count, const QModelIndex& parent) {
-   if (parent.isValid() || _frames.isEmpty())
+   if (parent.isValid() || _frameNames.isEmpty())
        return false;
 
    beginRemoveRows(parent, row, row + count - 1);
    for (int i = 0; i < count; ++i) {
-       _frames.removeAt(row);
+       _listedFrameNames.remove(_frameNames.takeAt(row));
    }
    endRemoveRows();
    return true;
 }
+
+void FrameComboBoxModel::RenameFrame(FrameHandle frameHandle, const QString& oldFrameName) {
+    if (!_listedFrameNames.remove(oldFrameName))
+        return;
+
+    const int row = _frameNames.indexOf(oldFrameName);
+    _frameNames[row] = _frameModel->Get(frameHandle)->GetName();
+    _listedFrameNames.insert(_frameNames[row]);
+    emit dataChanged(index(row), index(row), {Qt::DisplayRole});
+}
+
+void FrameComboBoxModel::ResetFrames() {
+    beginResetModel();
+    _frameNames = _frameModel ? _frameModel->GetFrameNames() : QStringList();
+    _listedFrameNames = QSet<QString>(_frameNames.cbegin(), _frameNames.cend());
+    endResetModel();
+}
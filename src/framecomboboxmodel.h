@@ -1,22 +1,34 @@
 #ifndef FRAMECOMBOBOXMODEL_H
 #define FRAMECOMBOBOXMODEL_H
 
+#include "framehandle.h"
 #include <QAbstractListModel>
+#include <QSet>
 
-class Frame;
+class FrameModel;
 
+// Список имён фреймов модели для выпадающих списков. Хранятся имена, а не FrameHandle: в модели из шардов
+// в списке есть и не загруженные фреймы, а выбранный фрейм подгружается, когда его запрашивают у модели
+// по имени (FrameModel::At). Выгрузка шардов список не меняет
 class FrameComboBoxModel : public QAbstractListModel {
 public:
     explicit FrameComboBoxModel(QObject* parent = nullptr);
-    void AddFrame(const Frame* frame);
-    void EraseFrame(const Frame* frame);
+    void SetModel(const FrameModel* frameModel);
+    void AddFrame(FrameHandle frameHandle);
+    void EraseFrame(FrameHandle frameHandle);
 
     QVariant data(const QModelIndex& index, int role) const override;
     int rowCount(const QModelIndex& = QModelIndex()) const override;
     bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
 
 private:
-    QList<const Frame*> _frames;
+    const FrameModel* _frameModel = nullptr;
+    QStringList _frameNames;
+    // Загрузка фрейма из FrameSource тоже испускает FrameAdded, но его имя уже есть в списке
+    QSet<QString> _listedFrameNames;
+
+    void RenameFrame(FrameHandle frameHandle, const QString& oldFrameName);
+    void ResetFrames();
 };
 
 #endif // FRAMECOMBOBOXMODEL_H
@@ -0,0 +1,34 @@
+#ifndef FRAMEHANDLE_H
+#define FRAMEHANDLE_H
+
+#include <QHash>
+#include <QMetaType>
+
+// Ссылка на фрейм в FramePool: индекс записи и её поколение. Поколение увеличивается при освобождении
+// записи, поэтому ссылка на удалённый фрейм не разыменуется в другой фрейм, занявший ту же запись
+struct FrameHandle {
+    inline static constexpr quint32 nullIndex = 0xFFFFFFFF;
+
+    quint32 index = nullIndex;
+    quint32 generation = 0;
+
+    bool IsNull() const {
+        return index == nullIndex;
+    }
+
+    friend bool operator==(FrameHandle left, FrameHandle right) {
+        return left.index == right.index && left.generation == right.generation;
+    }
+
+    friend bool operator!=(FrameHandle left, FrameHandle right) {
+        return !(left == right);
+    }
+};
+
+inline uint qHash(FrameHandle frameHandle, uint seed = 0) {
+    return qHash((quint64(frameHandle.index) << 32) | frameHandle.generation, seed);
+}
+
+Q_DECLARE_METATYPE(FrameHandle)
+
+#endif // FRAMEHANDLE_H
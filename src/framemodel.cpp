@@ -0,0 +1,840 @@
+#include "framemodel.h"
+#include "contenthash.h"
+#include "memoryusage.h"
+#include "profiler.h"
+#include <stdexcept>
+
+FrameModel::FrameModel(QObject* parent) : QObject(parent), _digestBuckets(_digestBucketsCount), _bucketDigests(_digestBucketsCount, 0)
+{
+}
+
+void FrameModel::SetFrameSource(FrameSource* frameSource) {
+    _frameSource = frameSource;
+
+    // Списки фреймов строятся заново уже по именам из источника
+    emit ModelReset();
+}
+
+const FramePool& FrameModel::GetFramePool() const {
+    return _framePool;
+}
+
+QStringList FrameModel::GetFrameNames() const {
+    if (_frameSource)
+        return _frameSource->GetFrameNames();
+
+    QStringList frameNames;
+    frameNames.reserve(_framePool.Size());
+
+    _framePool.ForEach([&](FrameHandle, const FramePool::Entry& entry) {
+        frameNames.append(entry.frame.GetName());
+    });
+
+    return frameNames;
+}
+
+FrameHandle FrameModel::Find(const QString& frameName) const {
+    return FindOrLoad(frameName);
+}
+
+bool FrameModel::Contains(const QString& frameName) const {
+    return !FindOrLoad(frameName).IsNull();
+}
+
+bool FrameModel::IsLoaded(const QString& frameName) const {
+    return _frameHandles.contains(frameName);
+}
+
+const Frame& FrameModel::At(const QString& frameName) const {
+    return _framePool.Get(HandleAt(frameName))->frame;
+}
+
+const Frame* FrameModel::Get(FrameHandle frameHandle) const {
+    const auto* entry = _framePool.Get(frameHandle);
+    return entry ? &entry->frame : nullptr;
+}
+
+QPoint FrameModel::GetPosition(FrameHandle frameHandle) const {
+    const auto* entry = _framePool.Get(frameHandle);
+    return entry ? entry->position : QPoint();
+}
+
+int FrameModel::Size() const {
+    return _framePool.Size();
+}
+
+bool FrameModel::IsEmpty() const {
+    return _framePool.IsEmpty();
+}
+
+QString FrameModel::SyntaxSearch(const QStringList& syntaxSearchSlotNames) const {
+    PROFILE_SCOPE("FrameModel::SyntaxSearch");
+
+    const auto isNeedToSearchFrameReference = syntaxSearchSlotNames.contains("Фрейм-ссылка");
+    QString syntaxSearchResult = syntaxSearchSlotNames.join(", ").prepend("Результат синтаксического поиска для слотов \"").append("\":\n");
+
+    ForEachFrame([&](FrameHandle, const FramePool::Entry& entry) {
+        for (const auto& [slotName, slotValueVariant] : entry.frame.GetSlots()) {
+            if (isNeedToSearchFrameReference && std::holds_alternative<FrameHandle>(slotValueVariant)) {
+                syntaxSearchResult.append("\"Фрейм-ссылка\"").append(" содержится во фрейме \"").append(entry.frame.GetName()).
+                                   append("\" со значением \"").append(slotName).append("\"\n");
+            }
+            else if (std::holds_alternative<QString>(slotValueVariant) && syntaxSearchSlotNames.contains(slotName)) {
+                syntaxSearchResult.append('\"').append(slotName).append("\" содержится во фрейме \"").append(entry.frame.GetName()).
+                                   append("\" со значением \"").append(std::get<QString>(slotValueVariant)).append("\"\n");
+            }
+        }
+    });
+
+    return syntaxSearchResult;
+}
+
+QString FrameModel::SemanticSearch(const QStringList& semanticSearchSlotValues) const {
+    PROFILE_SCOPE("FrameModel::SemanticSearch");
+
+    QString semanticSearchResult = semanticSearchSlotValues.join(", ").prepend("Результат семантического поиска для значения слотов \"").append("\":\n");
+
+    ForEachFrame([&](FrameHandle, const FramePool::Entry& entry) {
+        const auto slotsWithSearchValues = entry.frame.GetAllSlotsWithValues(semanticSearchSlotValues);
+
+        if (!slotsWithSearchValues.isEmpty()) {
+            semanticSearchResult.append("Содержится во фрейме \"").append(entry.frame.GetName()).append("\":\n");
+
+            for (const auto& slotSemanticSearchInfo : slotsWithSearchValues) {
+                semanticSearchResult.append("    — ").append(slotSemanticSearchInfo).append('\n');
+            }
+        }
+    });
+
+    return semanticSearchResult;
+}
+
+QString FrameModel::SubstringSearch(const QString& substring, Qt::CaseSensitivity caseSensitivity) const {
+    PROFILE_SCOPE("FrameModel::SubstringSearch");
+
+    QString substringSearchResult = QString("Результат поиска подстроки \"%1\" в именах и значениях слотов:\n").arg(substring);
+    const auto& slotStringPool = GetSlotStringPool();
+    int lastFrameIndex = -1;
+
+    // Слоты одного фрейма лежат в пуле подряд, поэтому фрейм достаточно упомянуть перед первым из них
+    slotStringPool.Search(substring, caseSensitivity, [&](const SlotStringPool::SlotLocation& slotLocation) {
+        if (slotLocation.frameIndex != lastFrameIndex) {
+            substringSearchResult.append("Содержится во фрейме \"").append(slotStringPool.GetFrameName(slotLocation)).append("\":\n");
+            lastFrameIndex = slotLocation.frameIndex;
+        }
+
+        substringSearchResult.append("    — ").append(Frame::GetSlotInfoText(slotStringPool.GetSlot(slotLocation))).append('\n');
+    });
+
+    return substringSearchResult;
+}
+
+FrameHandle FrameModel::AddFrame(Frame frame, QPoint framePosition) {
+    const auto existingFrameHandle = _frameHandles.value(frame.GetName());
+
+    NotifyFrameAboutToChange(frame.GetName(), existingFrameHandle);
+
+    // Как и раньше, фрейм с уже существующим именем заменяет собой прежний
+    if (auto* existingEntry = _framePool.Get(existingFrameHandle)) {
+        *existingEntry = {std::move(frame), framePosition};
+        UpdateFrameDigest(existingFrameHandle);
+        emit FrameChanged(existingFrameHandle);
+        emit FrameMoved(existingFrameHandle);
+        return existingFrameHandle;
+    }
+
+    const auto frameName = frame.GetName();
+    const auto frameHandle = _framePool.Create(std::move(frame), framePosition);
+    _frameHandles.insert(frameName, frameHandle);
+    UpdateFrameDigest(frameHandle);
+
+    emit FrameAdded(frameHandle);
+    ResolveReferences(frameName, frameHandle);
+    return frameHandle;
+}
+
+void FrameModel::EraseFrame(const QString& erasableFrameName) {
+    PROFILE_SCOPE("FrameModel::EraseFrame");
+
+    const auto erasableFrameHandle = HandleAt(erasableFrameName);
+
+    NotifyFrameAboutToChange(erasableFrameName, erasableFrameHandle);
+    emit FrameAboutToBeErased(erasableFrameHandle);
+
+    // Ссылки на удаляемый фрейм могут быть и в ещё не загруженных фреймах, поэтому обходятся все.
+    // FrameChanged испускается сразу: загруженные при обходе части источника могут быть снова выгружены до его конца
+    ForEachFrame([&](FrameHandle frameHandle, const FramePool::Entry& entry) {
+        if (frameHandle != erasableFrameHandle) {
+            const auto& frameSlots = entry.frame.GetSlots();
+            const auto foundErasableFrameIt = frameSlots.Find(erasableFrameName);
+
+            // Если удаляемый фрейм найден, как слот в каком-то другом фрейме, удаляем его из слотов этого фрейма тоже
+            if (foundErasableFrameIt != frameSlots.end()) {
+                // Если найденный слот с именем erasableFrameName действительно является фреймом
+                // (ссылкой на фрейм, который удаляется), тогда удаляем его из списка слотов у рассматриваемого фрейма
+                if (std::holds_alternative<FrameHandle>(foundErasableFrameIt->value)) {
+                    NotifyFrameAboutToChange(entry.frame.GetName(), frameHandle);
+                    _framePool.Get(frameHandle)->frame.EraseSlot(erasableFrameName);
+                    UpdateFrameDigest(frameHandle);
+                    emit FrameChanged(frameHandle);
+                }
+            }
+        }
+    });
+
+    _unresolvedReferences.remove(erasableFrameName);
+    RemoveFrameDigest(erasableFrameName);
+    _frameHandles.remove(erasableFrameName);
+    _framePool.Release(erasableFrameHandle);
+}
+
+QString FrameModel::FindFrameRenameConflict(const QString& oldFrameName, const QString& newFrameName) const {
+    QString conflictingFrameName;
+
+    ForEachFrame([&](FrameHandle, const FramePool::Entry& entry) {
+        const auto& frameSlots = entry.frame.GetSlots();
+        const auto foundRenamedFrameIt = frameSlots.Find(oldFrameName);
+
+        if (conflictingFrameName.isEmpty() && foundRenamedFrameIt != frameSlots.end() &&
+            std::holds_alternative<FrameHandle>(foundRenamedFrameIt->value) && frameSlots.Find(newFrameName) != frameSlots.end())
+            conflictingFrameName = entry.frame.GetName();
+    });
+
+    return conflictingFrameName;
+}
+
+void FrameModel::ReplaceFrameName(const QString& oldFrameName, QString newFrameName) {
+    PROFILE_SCOPE("FrameModel::ReplaceFrameName");
+
+    HandleAt(oldFrameName);
+
+    if (!FindFrameRenameConflict(oldFrameName, newFrameName).isEmpty())
+        throw std::invalid_argument("FrameModel::ReplaceFrameName");
+
+    ForEachFrame([&](FrameHandle frameHandle, const FramePool::Entry& entry) {
+        const auto& frameSlots = entry.frame.GetSlots();
+        const auto foundRenamedFrameIt = frameSlots.Find(oldFrameName);
+
+        // Если изменяемый фрейм найден, как слот-фрейм в каком-то другом фрейме, изменяем его имя (ключ) в слотах этого фрейма тоже
+        if (foundRenamedFrameIt != frameSlots.end() && std::holds_alternative<FrameHandle>(foundRenamedFrameIt->value)) {
+            if (std::get<FrameHandle>(foundRenamedFrameIt->value).IsNull())
+                _unresolvedReferences[newFrameName].append(frameHandle);
+
+            NotifyFrameAboutToChange(entry.frame.GetName(), frameHandle);
+            _framePool.Get(frameHandle)->frame.ReplaceSlotName(oldFrameName, newFrameName);
+            UpdateFrameDigest(frameHandle);
+            emit FrameChanged(frameHandle);
+        }
+    });
+
+    // При обходе источника сам фрейм мог быть выгружен, тогда он загружается снова
+    const auto renamedFrameHandle = HandleAt(oldFrameName);
+
+    NotifyFrameAboutToChange(oldFrameName, renamedFrameHandle);
+    NotifyFrameAboutToChange(newFrameName, FrameHandle());
+    _framePool.Get(renamedFrameHandle)->frame.SetName(newFrameName);
+    _unresolvedReferences.remove(oldFrameName);
+    _frameHandles.remove(oldFrameName);
+    _frameHandles.insert(newFrameName, renamedFrameHandle);
+    RemoveFrameDigest(oldFrameName);
+    UpdateFrameDigest(renamedFrameHandle);
+
+    emit FrameRenamed(renamedFrameHandle, oldFrameName);
+    ResolveReferences(newFrameName, renamedFrameHandle);
+}
+
+void FrameModel::ReplaceFrameCoords(const QString& frameName, const QString& x, const QString& y) {
+    auto framePosition = EntryAt(frameName).position;
+
+    if (!x.isEmpty()) framePosition.setX(x.toInt());
+    if (!y.isEmpty()) framePosition.setY(y.toInt());
+
+    SetFramePosition(HandleAt(frameName), framePosition);
+}
+
+void FrameModel::SetFramePosition(FrameHandle frameHandle, QPoint framePosition) {
+    auto* entry = _framePool.Get(frameHandle);
+
+    if (!entry || entry->position == framePosition)
+        return;
+
+    NotifyFrameAboutToChange(entry->frame.GetName(), frameHandle);
+    entry->position = framePosition;
+    UpdateFrameDigest(frameHandle);
+    emit FrameMoved(frameHandle);
+}
+
+void FrameModel::AddSlot(const QString& targetFrameName, QString slotName, QString slotValue) {
+    const auto targetFrameHandle = HandleAt(targetFrameName);
+
+    NotifyFrameAboutToChange(targetFrameName, targetFrameHandle);
+    _framePool.Get(targetFrameHandle)->frame.AddSlot(std::move(slotName), std::move(slotValue));
+    UpdateFrameDigest(targetFrameHandle);
+    emit FrameChanged(targetFrameHandle);
+}
+
+void FrameModel::AddFrameSlot(const QString& targetFrameName, const QString& slotFrameName) {
+    const auto targetFrameHandle = HandleAt(targetFrameName);
+    const auto slotFrameHandle = HandleAt(slotFrameName);
+
+    NotifyFrameAboutToChange(targetFrameName, targetFrameHandle);
+    _framePool.Get(targetFrameHandle)->frame.AddSlot(slotFrameName, slotFrameHandle);
+    UpdateFrameDigest(targetFrameHandle);
+    emit FrameChanged(targetFrameHandle);
+}
+
+void FrameModel::AddFrameReference(const QString& targetFrameName, const QString& slotFrameName) {
+    // В отличие от AddFrameSlot, фрейм-ссылка не подгружается: пока его нет в модели, ссылка остаётся неразрешённой
+    const auto targetFrameHandle = HandleAt(targetFrameName);
+    const auto slotFrameHandle = _frameHandles.value(slotFrameName);
+
+    NotifyFrameAboutToChange(targetFrameName, targetFrameHandle);
+    _framePool.Get(targetFrameHandle)->frame.AddSlot(slotFrameName, slotFrameHandle);
+
+    if (slotFrameHandle.IsNull())
+        _unresolvedReferences[slotFrameName].append(targetFrameHandle);
+
+    UpdateFrameDigest(targetFrameHandle);
+    emit FrameChanged(targetFrameHandle);
+}
+
+void FrameModel::ReplaceSlotName(const QString& frameName, const QString& oldSlotName, QString newSlotName) {
+    const auto frameHandle = HandleAt(frameName);
+
+    NotifyFrameAboutToChange(frameName, frameHandle);
+    _framePool.Get(frameHandle)->frame.ReplaceSlotName(oldSlotName, std::move(newSlotName));
+    UpdateFrameDigest(frameHandle);
+    emit FrameChanged(frameHandle);
+}
+
+void FrameModel::ReplaceSlotValue(const QString& frameName, const QString& slotName, QString slotValue) {
+    const auto frameHandle = HandleAt(frameName);
+
+    NotifyFrameAboutToChange(frameName, frameHandle);
+    _framePool.Get(frameHandle)->frame.ReplaceSlotValue(slotName, std::move(slotValue));
+    UpdateFrameDigest(frameHandle);
+    emit FrameChanged(frameHandle);
+}
+
+void FrameModel::EraseSlot(const QString& frameName, const QString& slotName) {
+    const auto frameHandle = HandleAt(frameName);
+
+    NotifyFrameAboutToChange(frameName, frameHandle);
+    _framePool.Get(frameHandle)->frame.EraseSlot(slotName);
+    UpdateFrameDigest(frameHandle);
+    emit FrameChanged(frameHandle);
+}
+
+void FrameModel::RestoreFrame(const QString& frameName, const FramePool::Entry* entry) {
+    const auto frameHandle = FindOrLoad(frameName);
+
+    // Слоты-фреймы с пустым FrameHandle ждут загрузки или появления фрейма, на который ссылаются
+    const auto forEachUnresolvedReference = [](const Frame& frame, auto callback) {
+        for (const auto& [slotName, slotValueVariant] : frame.GetSlots()) {
+            if (std::holds_alternative<FrameHandle>(slotValueVariant) && std::get<FrameHandle>(slotValueVariant).IsNull())
+                callback(slotName);
+        }
+    };
+
+    if (const auto* existingEntry = _framePool.Get(frameHandle)) {
+        forEachUnresolvedReference(existingEntry->frame, [&](const QString& slotName) {
+            RemoveUnresolvedReference(slotName, frameHandle);
+        });
+    }
+
+    if (!entry) {
+        if (frameHandle.IsNull())
+            return;
+
+        // В отличие от EraseFrame, ссылки на фрейм из других фреймов не удаляются: при откате истории
+        // их уже убрали восстановленные ранее версии тех фреймов
+        emit FrameAboutToBeErased(frameHandle);
+        RemoveFrameDigest(frameName);
+        _frameHandles.remove(frameName);
+        _framePool.Release(frameHandle);
+        return;
+    }
+
+    // Копия версии фрейма делит слоты с оригиналом, пока не понадобится обновить в ней FrameHandle ссылок:
+    // фреймы, на которые она ссылается, с тех пор могли быть удалены и созданы заново
+    auto restoredEntry = *entry;
+    bool hasStaleReferences = false;
+
+    for (const auto& [slotName, slotValueVariant] : qAsConst(restoredEntry.frame).GetSlots()) {
+        if (std::holds_alternative<FrameHandle>(slotValueVariant) && std::get<FrameHandle>(slotValueVariant) != _frameHandles.value(slotName))
+            hasStaleReferences = true;
+    }
+
+    if (hasStaleReferences) {
+        for (auto& [slotName, slotValueVariant] : restoredEntry.frame.GetSlots()) {
+            if (std::holds_alternative<FrameHandle>(slotValueVariant))
+                slotValueVariant = _frameHandles.value(slotName);
+        }
+    }
+
+    auto restoredFrameHandle = frameHandle;
+
+    if (auto* existingEntry = _framePool.Get(frameHandle))
+        *existingEntry = std::move(restoredEntry);
+    else
+        restoredFrameHandle = _framePool.Create(std::move(restoredEntry.frame), restoredEntry.position);
+
+    forEachUnresolvedReference(_framePool.Get(restoredFrameHandle)->frame, [&](const QString& slotName) {
+        _unresolvedReferences[slotName].append(restoredFrameHandle);
+    });
+
+    UpdateFrameDigest(restoredFrameHandle);
+
+    if (restoredFrameHandle == frameHandle) {
+        emit FrameChanged(frameHandle);
+        emit FrameMoved(frameHandle);
+        return;
+    }
+
+    _frameHandles.insert(frameName, restoredFrameHandle);
+    emit FrameAdded(restoredFrameHandle);
+    ResolveReferences(frameName, restoredFrameHandle);
+}
+
+void FrameModel::LoadArea(const QRect& area) {
+    if (!_frameSource)
+        return;
+
+    ++_sourceLoadsCount;
+    _frameSource->LoadArea(area);
+    --_sourceLoadsCount;
+}
+
+void FrameModel::UnloadFrames(const QVector<FrameHandle>& frameHandles) {
+    PROFILE_SCOPE("FrameModel::UnloadFrames");
+
+    QSet<FrameHandle> unloadedFrameHandles;
+    QVector<FrameHandle> changedFrameHandles;
+
+    for (const auto frameHandle : frameHandles) {
+        if (_framePool.IsValid(frameHandle))
+            unloadedFrameHandles.insert(frameHandle);
+    }
+
+    // Холст убирает выгружаемые фреймы, как удалённые, но одной перерисовкой, а списки фреймов, которые
+    // хранят имена, этот сигнал не слушают
+    emit FramesAboutToBeUnloaded(frameHandles);
+
+    _framePool.ForEach([&](FrameHandle frameHandle, FramePool::Entry& entry) {
+        const bool isUnloaded = unloadedFrameHandles.contains(frameHandle);
+        bool isChanged = false;
+
+        for (auto& [slotName, slotValueVariant] : entry.frame.GetSlots()) {
+            auto* slotFrameHandle = std::get_if<FrameHandle>(&slotValueVariant);
+
+            if (!slotFrameHandle)
+                continue;
+
+            if (isUnloaded) {
+                if (slotFrameHandle->IsNull())
+                    RemoveUnresolvedReference(slotName, frameHandle);
+            }
+            // Ссылки остающихся фреймов на выгружаемые разрешатся снова, когда те будут загружены
+            else if (unloadedFrameHandles.contains(*slotFrameHandle)) {
+                *slotFrameHandle = FrameHandle();
+                _unresolvedReferences[slotName].append(frameHandle);
+                isChanged = true;
+            }
+        }
+
+        if (isChanged)
+            changedFrameHandles.append(frameHandle);
+    });
+
+    for (const auto frameHandle : qAsConst(unloadedFrameHandles)) {
+        _frameHandles.remove(_framePool.Get(frameHandle)->frame.GetName());
+        _framePool.Release(frameHandle);
+    }
+
+    for (const auto changedFrameHandle : qAsConst(changedFrameHandles)) {
+        emit FrameChanged(changedFrameHandle);
+    }
+}
+
+void FrameModel::Reserve(int framesCount) {
+    _framePool.Reserve(framesCount);
+    _frameHandles.reserve(framesCount);
+}
+
+void FrameModel::Clear() {
+    _framePool.Clear();
+    _frameHandles.clear();
+    _internedStrings.clear();
+    _unresolvedReferences.clear();
+
+    for (auto& digestBucket : _digestBuckets) {
+        digestBucket.clear();
+    }
+
+    _bucketDigests.fill(0);
+    _isDigestDirty = true;
+    _isSlotStringPoolDirty = true;
+    emit ModelReset();
+}
+
+QString FrameModel::Intern(const QString& string) {
+    const auto internedStringIt = _internedStrings.constFind(string);
+
+    if (internedStringIt != _internedStrings.constEnd())
+        return *internedStringIt;
+
+    _internedStrings.insert(string);
+    return string;
+}
+
+quint64 FrameModel::GetDigest() const {
+    if (_isDigestDirty) {
+        _digest = _digestBucketsCount;
+
+        for (const auto bucketDigest : _bucketDigests) {
+            _digest = ContentHash::Combine(_digest, bucketDigest);
+        }
+
+        _isDigestDirty = false;
+    }
+
+    return _digest;
+}
+
+quint64 FrameModel::GetFrameDigest(const QString& frameName) const {
+    return _digestBuckets[GetDigestBucketIndex(frameName)].value(frameName);
+}
+
+int FrameModel::GetDigestBucketsCount() {
+    return _digestBucketsCount;
+}
+
+quint64 FrameModel::GetBucketDigest(int bucketIndex) const {
+    return _bucketDigests[bucketIndex];
+}
+
+const QHash<QString, quint64>& FrameModel::GetBucketFrameDigests(int bucketIndex) const {
+    return _digestBuckets[bucketIndex];
+}
+
+qint64 FrameModel::MemoryReport::GetTotalBytes() const {
+    return frameBytes + slotBytes + stringBytes + indexBytes;
+}
+
+FrameModel::MemoryReport FrameModel::GetMemoryReport() const {
+    MemoryReport report;
+    QSet<const QChar*> countedStrings;
+
+    // Строки с общим буфером (ключи индекса и имена фреймов, интернированные имена и значения слотов) учитываются один раз
+    auto countString = [&](const QString& string) {
+        if (!string.isEmpty() && !countedStrings.contains(string.constData())) {
+            countedStrings.insert(string.constData());
+            report.stringBytes += MemoryUsage::GetStringDataBytes(string);
+            ++report.stringsCount;
+        }
+    };
+
+    report.framesCount = _framePool.Size();
+    report.frameBytes = _framePool.GetBytes();
+    report.indexBytes = MemoryUsage::GetHashBytes(_frameHandles) + MemoryUsage::GetSetBytes(_internedStrings) +
+                        static_cast<qint64>(_bucketDigests.capacity()) * sizeof(quint64);
+
+    for (const auto& digestBucket : _digestBuckets) {
+        report.indexBytes += sizeof(digestBucket) + MemoryUsage::GetHashBytes(digestBucket);
+    }
+
+    report.indexBytes += _slotStringPool.GetBytes();
+
+    _framePool.ForEach([&](FrameHandle, const FramePool::Entry& entry) {
+        const auto& frameSlots = entry.frame.GetSlots();
+
+        countString(entry.frame.GetName());
+        report.slotsCount += frameSlots.Size();
+        report.slotBytes += frameSlots.GetSlotsBytes();
+        report.indexBytes += frameSlots.GetIndexBytes();
+
+        for (const auto& slot : frameSlots) {
+            countString(slot.name);
+
+            if (std::holds_alternative<QString>(slot.value))
+                countString(std::get<QString>(slot.value));
+        }
+    });
+
+    for (auto frameHandleIt = _frameHandles.cbegin(); frameHandleIt != _frameHandles.cend(); ++frameHandleIt) {
+        countString(frameHandleIt.key());
+    }
+
+    return report;
+}
+
+qint64 FrameModel::GetFrameBytes(FrameHandle frameHandle) const {
+    const auto* entry = _framePool.Get(frameHandle);
+
+    if (!entry)
+        return 0;
+
+    // Оценка сверху: строки, разделяемые с другими фреймами, учитываются в каждом из них
+    const auto& frameSlots = entry->frame.GetSlots();
+    qint64 frameBytes = sizeof(FramePool::Entry) + frameSlots.GetSlotsBytes() + frameSlots.GetIndexBytes() +
+                        MemoryUsage::GetStringDataBytes(entry->frame.GetName());
+
+    for (const auto& slot : frameSlots) {
+        frameBytes += MemoryUsage::GetStringDataBytes(slot.name);
+
+        if (std::holds_alternative<QString>(slot.value))
+            frameBytes += MemoryUsage::GetStringDataBytes(std::get<QString>(slot.value));
+    }
+
+    return frameBytes;
+}
+
+FrameHandle FrameModel::FindOrLoad(const QString& frameName) const {
+    auto frameHandleIt = _frameHandles.constFind(frameName);
+
+    if (frameHandleIt == _frameHandles.constEnd() && _frameSource) {
+        ++_sourceLoadsCount;
+
+        if (_frameSource->LoadFrame(frameName))
+            frameHandleIt = _frameHandles.constFind(frameName);
+
+        --_sourceLoadsCount;
+    }
+
+    return frameHandleIt != _frameHandles.constEnd() ? frameHandleIt.value() : FrameHandle();
+}
+
+FrameHandle FrameModel::HandleAt(const QString& frameName) const {
+    const auto frameHandle = FindOrLoad(frameName);
+
+    if (frameHandle.IsNull())
+        throw std::out_of_range("FrameModel::At");
+
+    return frameHandle;
+}
+
+FramePool::Entry& FrameModel::EntryAt(const QString& frameName) {
+    return *_framePool.Get(HandleAt(frameName));
+}
+
+void FrameModel::ResolveReferences(const QString& frameName, FrameHandle frameHandle) {
+    const auto sourceFrameHandles = _unresolvedReferences.take(frameName);
+
+    for (const auto sourceFrameHandle : sourceFrameHandles) {
+        auto* sourceEntry = _framePool.Get(sourceFrameHandle);
+
+        if (!sourceEntry)
+            continue;
+
+        auto& sourceFrameSlots = sourceEntry->frame.GetSlots();
+        const auto slotIt = sourceFrameSlots.Find(frameName);
+
+        if (slotIt != sourceFrameSlots.end() && std::holds_alternative<FrameHandle>(slotIt->value)) {
+            slotIt->value = frameHandle;
+            emit FrameChanged(sourceFrameHandle);
+        }
+    }
+}
+
+void FrameModel::NotifyFrameAboutToChange(const QString& frameName, FrameHandle frameHandle) {
+    // Фреймы, загружаемые из FrameSource, уже были частью модели, и их добавление изменением не считается
+    if (_sourceLoadsCount == 0)
+        emit FrameAboutToChange(frameName, frameHandle);
+}
+
+void FrameModel::UpdateFrameDigest(FrameHandle frameHandle) {
+    const auto* entry = _framePool.Get(frameHandle);
+    const auto& frameName = entry->frame.GetName();
+    const int bucketIndex = GetDigestBucketIndex(frameName);
+    auto& digestBucket = _digestBuckets[bucketIndex];
+    const auto frameDigest = ContentHash::Combine(entry->frame.GetContentHash(),
+                                                  quint64(quint32(entry->position.x())) << 32 | quint32(entry->position.y()));
+    auto frameDigestIt = digestBucket.find(frameName);
+
+    // Дайджест корзины — сумма дайджестов её фреймов, поэтому изменение фрейма меняет его на разность
+    if (frameDigestIt == digestBucket.end()) {
+        digestBucket.insert(frameName, frameDigest);
+        _bucketDigests[bucketIndex] += frameDigest;
+    }
+    else {
+        _bucketDigests[bucketIndex] += frameDigest - frameDigestIt.value();
+        frameDigestIt.value() = frameDigest;
+    }
+
+    _isDigestDirty = true;
+
+    // Загрузка фрейма из FrameSource содержимое модели не меняет
+    if (_sourceLoadsCount == 0)
+        _isSlotStringPoolDirty = true;
+}
+
+void FrameModel::RemoveFrameDigest(const QString& frameName) {
+    const int bucketIndex = GetDigestBucketIndex(frameName);
+    const auto frameDigestIt = _digestBuckets[bucketIndex].find(frameName);
+
+    if (frameDigestIt == _digestBuckets[bucketIndex].end())
+        return;
+
+    _bucketDigests[bucketIndex] -= frameDigestIt.value();
+    _digestBuckets[bucketIndex].erase(frameDigestIt);
+    _isDigestDirty = true;
+    _isSlotStringPoolDirty = true;
+}
+
+const SlotStringPool& FrameModel::GetSlotStringPool() const {
+    const QMutexLocker slotStringPoolLocker(&_slotStringPoolMutex);
+
+    if (_isSlotStringPoolDirty) {
+        PROFILE_SCOPE("FrameModel::GetSlotStringPool");
+
+        _slotStringPool.Clear();
+
+        ForEachFrame([&](FrameHandle, const FramePool::Entry& entry) {
+            _slotStringPool.Append(entry.frame);
+        });
+
+        _isSlotStringPoolDirty = false;
+        PROFILE_COUNTER("Пул строк слотов: память, байт", _slotStringPool.GetBytes());
+    }
+
+    return _slotStringPool;
+}
+
+int FrameModel::GetDigestBucketIndex(const QString& frameName) {
+    return static_cast<int>(ContentHash::HashString(frameName) % _digestBucketsCount);
+}
+
+void FrameModel::RemoveUnresolvedReference(const QString& slotFrameName, FrameHandle sourceFrameHandle) {
+    const auto unresolvedIt = _unresolvedReferences.find(slotFrameName);
+
+    if (unresolvedIt == _unresolvedReferences.end())
+        return;
+
+    unresolvedIt->removeOne(sourceFrameHandle);
+
+    if (unresolvedIt->isEmpty())
+        _unresolvedReferences.erase(unresolvedIt);
+}
+
+FrameModel::BulkUpdate::BulkUpdate(FrameModel* frameModel) : _frameModel(frameModel) {
+    Q_ASSERT(!frameModel->_frameSource);
+}
+
+FrameModel::BulkUpdate::~BulkUpdate() {
+    Rollback();
+}
+
+FrameHandle FrameModel::BulkUpdate::AddFrame(const QString& frameName, QPoint framePosition) {
+    const auto existingFrameHandle = _frameModel->_frameHandles.value(frameName);
+
+    if (!existingFrameHandle.IsNull()) {
+        Touch(existingFrameHandle).position = framePosition;
+        return existingFrameHandle;
+    }
+
+    _frameModel->NotifyFrameAboutToChange(frameName, FrameHandle());
+
+    const auto frameHandle = _frameModel->_framePool.Create(Frame(frameName), framePosition);
+    _frameModel->_frameHandles.insert(frameName, frameHandle);
+    _frameModel->_framePool.Get(frameHandle)->frame.BeginSlotsUpdate();
+    _originalEntries.insert(frameName, std::nullopt);
+    _changedFrameHandles.append(frameHandle);
+
+    // В отличие от FrameModel::ResolveReferences, фреймы, ждавшие нового фрейма, тоже считаются изменёнными в пакете
+    const auto sourceFrameHandles = _frameModel->_unresolvedReferences.take(frameName);
+
+    for (const auto sourceFrameHandle : sourceFrameHandles) {
+        if (!_frameModel->_framePool.IsValid(sourceFrameHandle))
+            continue;
+
+        auto& sourceFrameSlots = Touch(sourceFrameHandle).frame.GetSlots();
+        const auto slotIt = sourceFrameSlots.Find(frameName);
+
+        if (slotIt != sourceFrameSlots.end() && std::holds_alternative<FrameHandle>(slotIt->value))
+            slotIt->value = frameHandle;
+    }
+
+    return frameHandle;
+}
+
+void FrameModel::BulkUpdate::AddSlot(FrameHandle targetFrameHandle, QString slotName, QString slotValue) {
+    Touch(targetFrameHandle).frame.AddSlot(std::move(slotName), std::move(slotValue));
+}
+
+void FrameModel::BulkUpdate::AddFrameReference(FrameHandle targetFrameHandle, const QString& slotFrameName) {
+    const auto slotFrameHandle = _frameModel->_frameHandles.value(slotFrameName);
+
+    Touch(targetFrameHandle).frame.AddSlot(slotFrameName, slotFrameHandle);
+
+    if (slotFrameHandle.IsNull())
+        _frameModel->_unresolvedReferences[slotFrameName].append(targetFrameHandle);
+}
+
+void FrameModel::BulkUpdate::EraseFrameReference(FrameHandle targetFrameHandle, const QString& slotFrameName) {
+    Touch(targetFrameHandle).frame.EraseSlot(slotFrameName);
+    _frameModel->RemoveUnresolvedReference(slotFrameName, targetFrameHandle);
+}
+
+int FrameModel::BulkUpdate::GetChangedFramesCount() const {
+    return _changedFrameHandles.size();
+}
+
+void FrameModel::BulkUpdate::Commit() {
+    if (_isFinished)
+        return;
+
+    PROFILE_SCOPE("FrameModel::BulkUpdate::Commit");
+
+    // Самый длинный слот и дайджест каждого изменённого фрейма вычисляются один раз, сколько бы слотов ни добавилось
+    for (const auto frameHandle : qAsConst(_changedFrameHandles)) {
+        _frameModel->_framePool.Get(frameHandle)->frame.EndSlotsUpdate();
+        _frameModel->UpdateFrameDigest(frameHandle);
+    }
+
+    _isFinished = true;
+    _originalEntries.clear();
+    _changedFrameHandles.clear();
+    emit _frameModel->BulkUpdateFinished();
+}
+
+void FrameModel::BulkUpdate::Rollback() {
+    if (_isFinished)
+        return;
+
+    PROFILE_SCOPE("FrameModel::BulkUpdate::Rollback");
+
+    // Представления не знают о фреймах пакета, поэтому сигналы RestoreFrame им не нужны.
+    // Сначала удаляются добавленные фреймы, чтобы ссылки на них в восстановленных версиях снова стали неразрешёнными
+    const bool wereSignalsBlocked = _frameModel->blockSignals(true);
+
+    for (auto originalEntryIt = _originalEntries.cbegin(); originalEntryIt != _originalEntries.cend(); ++originalEntryIt) {
+        if (!originalEntryIt.value())
+            _frameModel->RestoreFrame(originalEntryIt.key(), nullptr);
+    }
+
+    for (auto originalEntryIt = _originalEntries.cbegin(); originalEntryIt != _originalEntries.cend(); ++originalEntryIt) {
+        if (originalEntryIt.value())
+            _frameModel->RestoreFrame(originalEntryIt.key(), &*originalEntryIt.value());
+    }
+
+    _frameModel->blockSignals(wereSignalsBlocked);
+
+    _isFinished = true;
+    _originalEntries.clear();
+    _changedFrameHandles.clear();
+    emit _frameModel->BulkUpdateFinished();
+}
+
+FramePool::Entry& FrameModel::BulkUpdate::Touch(FrameHandle frameHandle) {
+    auto* entry = _frameModel->_framePool.Get(frameHandle);
+    const auto& frameName = entry->frame.GetName();
+
+    if (!_originalEntries.contains(frameName)) {
+        _frameModel->NotifyFrameAboutToChange(frameName, frameHandle);
+        _originalEntries.insert(frameName, *entry);
+        _changedFrameHandles.append(frameHandle);
+        entry->frame.BeginSlotsUpdate();
+    }
+
+    return *entry;
+}
@@ -0,0 +1,194 @@
+#ifndef FRAMEMODEL_H
+#define FRAMEMODEL_H
+
+#include "framepool.h"
+#include "framesource.h"
+#include "slotstringpool.h"
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <optional>
+
+// Данные фреймовой модели: фреймы в FramePool и индекс [FrameName, FrameHandle]. Все изменения
+// проходят через методы модели, которые сообщают о них сигналами, поэтому представления
+// (холст и списки фреймов) хранят только FrameHandle и не могут обратиться к удалённому фрейму.
+// Если задан FrameSource, в модели находится только часть фреймов: поиск фрейма по имени подгружает
+// его из источника, а поиск по слотам, удаление и переименование обходят весь источник
+class FrameModel : public QObject {
+    Q_OBJECT
+
+public:
+    struct MemoryReport {
+        qint64 framesCount = 0, slotsCount = 0, stringsCount = 0;
+        qint64 frameBytes = 0, slotBytes = 0, stringBytes = 0, indexBytes = 0;
+
+        qint64 GetTotalBytes() const;
+    };
+
+    // Пакетное изменение модели, например при импорте таблицы. Фреймы и слоты добавляются без сигналов
+    // о каждом из них, без обновления дайджеста и без пересчёта самого длинного слота фрейма: перед первым
+    // изменением фрейма в пакете испускается только FrameAboutToChange, чтобы история правок запомнила его
+    // прежнюю версию. Commit доводит изменённые фреймы до согласованного состояния и испускает
+    // BulkUpdateFinished, по которому представления перестраиваются один раз. Rollback, как и деструктор
+    // без Commit, возвращает изменённым фреймам прежние версии, а добавленные удаляет.
+    // Модель с FrameSource так не изменяется: источник узнаёт об изменениях фреймов только по сигналам
+    class BulkUpdate {
+    public:
+        explicit BulkUpdate(FrameModel* frameModel);
+        ~BulkUpdate();
+        BulkUpdate(const BulkUpdate&) = delete;
+        BulkUpdate& operator=(const BulkUpdate&) = delete;
+
+        // Фрейм с уже существующим именем не заменяется, а только перемещается: слоты добавляются к его слотам
+        FrameHandle AddFrame(const QString& frameName, QPoint framePosition);
+        void AddSlot(FrameHandle targetFrameHandle, QString slotName, QString slotValue);
+        // Как FrameModel::AddFrameReference: ссылка на фрейм, которого ещё нет, разрешится при его добавлении
+        void AddFrameReference(FrameHandle targetFrameHandle, const QString& slotFrameName);
+        // Убирает неразрешённую ссылку, добавленную в пакете, если её фрейм так и не появился
+        void EraseFrameReference(FrameHandle targetFrameHandle, const QString& slotFrameName);
+        int GetChangedFramesCount() const;
+        void Commit();
+        void Rollback();
+
+    private:
+        FrameModel* _frameModel;
+        // [FrameName, версия фрейма до пакета (std::nullopt — фрейма не было)]
+        QHash<QString, std::optional<FramePool::Entry>> _originalEntries;
+        QVector<FrameHandle> _changedFrameHandles;
+        bool _isFinished = false;
+
+        FramePool::Entry& Touch(FrameHandle frameHandle);
+    };
+
+    explicit FrameModel(QObject* parent = nullptr);
+    void SetFrameSource(FrameSource* frameSource);
+    const FramePool& GetFramePool() const;
+    // Имена всех фреймов модели, включая ещё не загруженные из FrameSource
+    QStringList GetFrameNames() const;
+    FrameHandle Find(const QString& frameName) const;
+    bool Contains(const QString& frameName) const;
+    bool IsLoaded(const QString& frameName) const;
+    const Frame& At(const QString& frameName) const;
+    const Frame* Get(FrameHandle frameHandle) const;
+    QPoint GetPosition(FrameHandle frameHandle) const;
+    int Size() const;
+    bool IsEmpty() const;
+    QString SyntaxSearch(const QStringList& syntaxSearchSlotNames) const;
+    QString SemanticSearch(const QStringList& semanticSearchSlotValues) const;
+    // Поиск подстроки в именах и значениях слотов по SlotStringPool
+    QString SubstringSearch(const QString& substring, Qt::CaseSensitivity caseSensitivity) const;
+    quint64 GetDigest() const;
+    quint64 GetFrameDigest(const QString& frameName) const;
+    static int GetDigestBucketsCount();
+    quint64 GetBucketDigest(int bucketIndex) const;
+    const QHash<QString, quint64>& GetBucketFrameDigests(int bucketIndex) const;
+    FrameHandle AddFrame(Frame frame, QPoint framePosition);
+    void EraseFrame(const QString& erasableFrameName);
+    // Фрейм, который ссылается на oldFrameName и уже содержит слот newFrameName: переименование дало бы ему
+    // два слота с одним именем. Пустая строка, если таких фреймов нет
+    QString FindFrameRenameConflict(const QString& oldFrameName, const QString& newFrameName) const;
+    // Бросает std::invalid_argument, если FindFrameRenameConflict нашёл конфликт; модель при этом не меняется
+    void ReplaceFrameName(const QString& oldFrameName, QString newFrameName);
+    void ReplaceFrameCoords(const QString& frameName, const QString& x, const QString& y);
+    void SetFramePosition(FrameHandle frameHandle, QPoint framePosition);
+    void AddSlot(const QString& targetFrameName, QString slotName, QString slotValue);
+    void AddFrameSlot(const QString& targetFrameName, const QString& slotFrameName);
+    void AddFrameReference(const QString& targetFrameName, const QString& slotFrameName);
+    void ReplaceSlotName(const QString& frameName, const QString& oldSlotName, QString newSlotName);
+    void ReplaceSlotValue(const QString& frameName, const QString& slotName, QString slotValue);
+    void EraseSlot(const QString& frameName, const QString& slotName);
+    // Возвращает фрейму сохранённую версию (entry == nullptr — удаляет его), не трогая другие фреймы.
+    // Для отмены и повтора правок: FrameAboutToChange при этом не испускается
+    void RestoreFrame(const QString& frameName, const FramePool::Entry* entry);
+    void LoadArea(const QRect& area);
+    void UnloadFrames(const QVector<FrameHandle>& frameHandles);
+    void Reserve(int framesCount);
+    void Clear();
+    QString Intern(const QString& string);
+    MemoryReport GetMemoryReport() const;
+    qint64 GetFrameBytes(FrameHandle frameHandle) const;
+
+signals:
+    // Испускается перед изменением фрейма, в том числе перед созданием фрейма с таким именем
+    // (тогда frameHandle пуст), но не при загрузке фреймов из FrameSource
+    void FrameAboutToChange(const QString& frameName, FrameHandle frameHandle);
+    void FrameAdded(FrameHandle frameHandle);
+    void FrameAboutToBeErased(FrameHandle frameHandle);
+    // Фреймы выгружаются в FrameSource: из модели они не удаляются и по имени загрузятся снова
+    void FramesAboutToBeUnloaded(const QVector<FrameHandle>& frameHandles);
+    void FrameRenamed(FrameHandle frameHandle, const QString& oldFrameName);
+    // Изменились слоты фрейма
+    void FrameChanged(FrameHandle frameHandle);
+    void FrameMoved(FrameHandle frameHandle);
+    void ModelReset();
+    // Завершился BulkUpdate: любые фреймы могли быть добавлены или изменены
+    void BulkUpdateFinished();
+
+private:
+    FramePool _framePool;
+    // [FrameName, FrameHandle]
+    QHash<QString, FrameHandle> _frameHandles;
+    // Повторяющиеся имена и значения слотов хранятся в единственном экземпляре за счёт неявного разделения QString
+    QSet<QString> _internedStrings;
+    FrameSource* _frameSource = nullptr;
+    // Слоты-фреймы, ссылающиеся на ещё не загруженные фреймы, хранят пустой FrameHandle и получают
+    // настоящий при загрузке фрейма: [SlotFrameName, SourceFrameHandles]
+    QHash<QString, QVector<FrameHandle>> _unresolvedReferences;
+    // Дайджест модели в духе дерева Меркла. Дайджест фрейма (хеш его имени, слотов и позиции) хранится
+    // в одной из корзин по хешу имени, дайджест корзины — сумма дайджестов её фреймов, а дайджест модели —
+    // хеш последовательности дайджестов корзин. Мутаторы модели обновляют только дайджест изменённого
+    // фрейма и его корзины, а модели с разными дайджестами корзин достаточно сравнить лишь в этих корзинах.
+    // Выгрузка фреймов в FrameSource дайджест не меняет: фреймы остаются частью модели, а при повторной
+    // загрузке получают тот же дайджест
+    QVector<QHash<QString, quint64>> _digestBuckets; // [FrameName, FrameDigest]
+    QVector<quint64> _bucketDigests;
+    mutable quint64 _digest = 0;
+    mutable bool _isDigestDirty = true;
+    // Пул строк слотов для поиска подстроки строится при первом поиске после изменения модели.
+    // Сервер запросов ищет в одной модели из нескольких потоков, поэтому построение идёт под мьютексом
+    mutable SlotStringPool _slotStringPool;
+    mutable bool _isSlotStringPoolDirty = true;
+    mutable QMutex _slotStringPoolMutex;
+    // Глубина вложенности вызовов FrameSource, загружающих фреймы
+    mutable int _sourceLoadsCount = 0;
+
+    inline static constexpr int _digestBucketsCount = 4096;
+
+    FrameHandle FindOrLoad(const QString& frameName) const;
+    FrameHandle HandleAt(const QString& frameName) const;
+    FramePool::Entry& EntryAt(const QString& frameName);
+    void ResolveReferences(const QString& frameName, FrameHandle frameHandle);
+    void RemoveUnresolvedReference(const QString& slotFrameName, FrameHandle sourceFrameHandle);
+    void NotifyFrameAboutToChange(const QString& frameName, FrameHandle frameHandle);
+    void UpdateFrameDigest(FrameHandle frameHandle);
+    void RemoveFrameDigest(const QString& frameName);
+    const SlotStringPool& GetSlotStringPool() const;
+    static int GetDigestBucketIndex(const QString& frameName);
+
+    // Обход всех фреймов модели, включая ещё не загруженные из FrameSource: callback(FrameHandle, const Entry&)
+    template <typename Callback>
+    void ForEachFrame(Callback callback) const {
+        if (!_frameSource) {
+            _framePool.ForEach(callback);
+            return;
+        }
+
+        // Загрузка частей не считается изменением модели, в отличие от правок в самом callback
+        ++_sourceLoadsCount;
+
+        _frameSource->ForEachPart([&](const QVector<FrameHandle>& frameHandles) {
+            --_sourceLoadsCount;
+
+            for (const auto frameHandle : frameHandles) {
+                if (const auto* entry = _framePool.Get(frameHandle))
+                    callback(frameHandle, *entry);
+            }
+
+            ++_sourceLoadsCount;
+        });
+
+        --_sourceLoadsCount;
+    }
+};
+
+#endif // FRAMEMODEL_H
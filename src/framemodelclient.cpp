@@ -0,0 +1,90 @@
+#include "framemodelclient.h"
+#include <QDeadlineTimer>
+
+bool FrameModelClient::Connect(const QString& serverName, int timeoutMs) {
+    Disconnect();
+    _socket.connectToServer(serverName);
+    return _socket.waitForConnected(timeoutMs);
+}
+
+void FrameModelClient::Disconnect() {
+    _socket.abort();
+    _buffer.clear();
+    _receivedResponses.clear();
+}
+
+bool FrameModelClient::IsConnected() const {
+    return _socket.state() == QLocalSocket::ConnectedState;
+}
+
+QString FrameModelClient::GetErrorString() const {
+    return _socket.errorString();
+}
+
+quint64 FrameModelClient::Send(FrameModelProtocol::Command command, const QStringList& arguments) {
+    const auto requestId = _nextRequestId++;
+
+    _socket.write(FrameModelProtocol::EncodeRequest({requestId, command, arguments}));
+    _socket.flush();
+    return requestId;
+}
+
+bool FrameModelClient::Receive(FrameModelProtocol::Response& response, int timeoutMs) {
+    if (!_receivedResponses.isEmpty()) {
+        const auto receivedResponseIt = _receivedResponses.begin();
+        response = receivedResponseIt.value();
+        _receivedResponses.erase(receivedResponseIt);
+        return true;
+    }
+
+    return ReadResponse(response, timeoutMs);
+}
+
+bool FrameModelClient::Query(FrameModelProtocol::Command command, const QStringList& arguments, QString& result, int timeoutMs) {
+    const auto requestId = Send(command, arguments);
+    const QDeadlineTimer deadline(timeoutMs);
+    FrameModelProtocol::Response response;
+
+    // Ответы на другие конвейерные запросы откладываются до их Receive
+    while (ReadResponse(response, deadline.remainingTime()) && response.requestId != requestId) {
+        _receivedResponses.insert(response.requestId, response);
+    }
+
+    if (response.requestId != requestId)
+        return false;
+
+    result = response.text;
+    return response.isOk;
+}
+
+bool FrameModelClient::SyntaxSearch(const QStringList& syntaxSearchSlotNames, QString& result) {
+    return Query(FrameModelProtocol::Command::SyntaxSearch, syntaxSearchSlotNames, result);
+}
+
+bool FrameModelClient::SemanticSearch(const QStringList& semanticSearchSlotValues, QString& result) {
+    return Query(FrameModelProtocol::Command::SemanticSearch, semanticSearchSlotValues, result);
+}
+
+bool FrameModelClient::SubstringSearch(const QString& substring, Qt::CaseSensitivity caseSensitivity, QString& result) {
+    QStringList arguments {substring};
+
+    if (caseSensitivity == Qt::CaseInsensitive)
+        arguments.append(FrameModelProtocol::caseFoldFlag);
+
+    return Query(FrameModelProtocol::Command::SubstringSearch, arguments, result);
+}
+
+bool FrameModelClient::ReadResponse(FrameModelProtocol::Response& response, int timeoutMs) {
+    const QDeadlineTimer deadline(timeoutMs);
+
+    _buffer += _socket.readAll();
+
+    while (!FrameModelProtocol::DecodeResponse(_buffer, response)) {
+        if (!IsConnected() || !_socket.waitForReadyRead(deadline.remainingTime()))
+            return false;
+
+        _buffer += _socket.readAll();
+    }
+
+    return true;
+}
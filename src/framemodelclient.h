@@ -0,0 +1,41 @@
+#ifndef FRAMEMODELCLIENT_H
+#define FRAMEMODELCLIENT_H
+
+#include "framemodelprotocol.h"
+#include <QHash>
+#include <QLocalSocket>
+
+// Клиент сервера запросов к модели. Работает в блокирующем режиме и не требует цикла событий,
+// поэтому подходит для скриптов и рабочих потоков; один объект нельзя использовать из нескольких потоков.
+// Query отправляет запрос и ждёт ответа на него, а пара Send/Receive позволяет держать в работе
+// несколько запросов сразу
+class FrameModelClient {
+public:
+    bool Connect(const QString& serverName = FrameModelProtocol::defaultServerName, int timeoutMs = _defaultTimeoutMs);
+    void Disconnect();
+    bool IsConnected() const;
+    QString GetErrorString() const;
+
+    // Возвращает RequestId отправленного запроса
+    quint64 Send(FrameModelProtocol::Command command, const QStringList& arguments = QStringList());
+    // Ответ на любой из отправленных запросов, в порядке их выполнения сервером
+    bool Receive(FrameModelProtocol::Response& response, int timeoutMs = _defaultTimeoutMs);
+
+    bool Query(FrameModelProtocol::Command command, const QStringList& arguments, QString& result, int timeoutMs = _defaultTimeoutMs);
+    bool SyntaxSearch(const QStringList& syntaxSearchSlotNames, QString& result);
+    bool SemanticSearch(const QStringList& semanticSearchSlotValues, QString& result);
+    bool SubstringSearch(const QString& substring, Qt::CaseSensitivity caseSensitivity, QString& result);
+
+private:
+    QLocalSocket _socket;
+    QByteArray _buffer; // Ещё не разобранные байты ответов
+    // Ответы на другие запросы, пришедшие, пока Query ждал свой
+    QHash<quint64, FrameModelProtocol::Response> _receivedResponses;
+    quint64 _nextRequestId = 1;
+
+    inline static constexpr int _defaultTimeoutMs = 30000;
+
+    bool ReadResponse(FrameModelProtocol::Response& response, int timeoutMs);
+};
+
+#endif // FRAMEMODELCLIENT_H
@@ -0,0 +1,245 @@
+#include "framemodeldiff.h"
+#include "profiler.h"
+#include <algorithm>
+
+namespace {
+    FrameModelDiff::SlotState ToSlotState(const Frame::Slots::Slot& slot) {
+        if (std::holds_alternative<QString>(slot.value))
+            return {true, false, std::get<QString>(slot.value)};
+        else
+            return {true, true, QString()};
+    }
+
+    // Разность слотов двух версий фрейма; frame == nullptr — фрейма в этой версии нет
+    QVector<FrameModelDiff::SlotDifference> CompareSlots(const Frame* oldFrame, const Frame* newFrame) {
+        QVector<FrameModelDiff::SlotDifference> slotDifferences;
+
+        if (oldFrame) {
+            for (const auto& slot : oldFrame->GetSlots()) {
+                const auto newSlotState = FrameModelDiff::GetSlotState(newFrame, slot.name);
+
+                if (newSlotState != ToSlotState(slot))
+                    slotDifferences.append({slot.name, ToSlotState(slot), newSlotState});
+            }
+        }
+
+        if (newFrame) {
+            for (const auto& slot : newFrame->GetSlots()) {
+                if (!oldFrame || !oldFrame->Contains(slot.name))
+                    slotDifferences.append({slot.name, {}, ToSlotState(slot)});
+            }
+        }
+
+        std::sort(slotDifferences.begin(), slotDifferences.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.slotName < rhs.slotName;
+        });
+
+        return slotDifferences;
+    }
+
+    FrameModelDiff::FrameDifference CompareFrames(const FrameModel* oldFrameModel, const FrameModel* newFrameModel, const QString& frameName) {
+        FrameModelDiff::FrameDifference frameDifference {frameName, QPoint(), QPoint(), {}};
+        const Frame* oldFrame = nullptr;
+        const Frame* newFrame = nullptr;
+
+        if (oldFrameModel) {
+            const auto oldFrameHandle = oldFrameModel->Find(frameName);
+            oldFrame = oldFrameModel->Get(oldFrameHandle);
+            frameDifference.oldPosition = oldFrameModel->GetPosition(oldFrameHandle);
+        }
+
+        if (newFrameModel) {
+            const auto newFrameHandle = newFrameModel->Find(frameName);
+            newFrame = newFrameModel->Get(newFrameHandle);
+            frameDifference.newPosition = newFrameModel->GetPosition(newFrameHandle);
+        }
+
+        frameDifference.slotDifferences = CompareSlots(oldFrame, newFrame);
+        return frameDifference;
+    }
+
+    QString GetSlotStateText(const QString& slotName, const FrameModelDiff::SlotState& slotState) {
+        if (slotState.isFrameReference)
+            return Frame::GetSlotInfoText({slotName, FrameHandle()});
+        else
+            return Frame::GetSlotInfoText({slotName, slotState.value});
+    }
+
+    QString GetPositionText(QPoint position) {
+        return QString("(%1, %2)").arg(position.x()).arg(position.y());
+    }
+
+    void SortByFrameName(QVector<FrameModelDiff::FrameDifference>& frameDifferences) {
+        std::sort(frameDifferences.begin(), frameDifferences.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.frameName < rhs.frameName;
+        });
+    }
+}
+
+bool FrameModelDiff::SlotState::operator==(const SlotState& other) const {
+    return isPresent == other.isPresent && isFrameReference == other.isFrameReference && value == other.value;
+}
+
+bool FrameModelDiff::SlotState::operator!=(const SlotState& other) const {
+    return !(*this == other);
+}
+
+bool FrameModelDiff::IsEmpty() const {
+    return addedFrames.isEmpty() && removedFrames.isEmpty() && changedFrames.isEmpty();
+}
+
+QString FrameModelDiff::ToText() const {
+    QString text;
+
+    const auto appendSlotDifferences = [&](const FrameDifference& frameDifference) {
+        for (const auto& slotDifference : frameDifference.slotDifferences) {
+            if (!slotDifference.oldState.isPresent)
+                text += "    + " + GetSlotStateText(slotDifference.slotName, slotDifference.newState) + '\n';
+            else if (!slotDifference.newState.isPresent)
+                text += "    - " + GetSlotStateText(slotDifference.slotName, slotDifference.oldState) + '\n';
+            else
+                text += "    ~ " + GetSlotStateText(slotDifference.slotName, slotDifference.oldState) + " -> " +
+                        GetSlotStateText(slotDifference.slotName, slotDifference.newState) + '\n';
+        }
+    };
+
+    for (const auto& frameDifference : addedFrames) {
+        text += QString("+ Фрейм \"%1\" %2\n").arg(frameDifference.frameName, GetPositionText(frameDifference.newPosition));
+        appendSlotDifferences(frameDifference);
+    }
+
+    for (const auto& frameDifference : removedFrames) {
+        text += QString("- Фрейм \"%1\" %2\n").arg(frameDifference.frameName, GetPositionText(frameDifference.oldPosition));
+        appendSlotDifferences(frameDifference);
+    }
+
+    for (const auto& frameDifference : changedFrames) {
+        text += QString("~ Фрейм \"%1\"").arg(frameDifference.frameName);
+
+        if (frameDifference.oldPosition != frameDifference.newPosition)
+            text += ' ' + GetPositionText(frameDifference.oldPosition) + " -> " + GetPositionText(frameDifference.newPosition);
+
+        text += '\n';
+        appendSlotDifferences(frameDifference);
+    }
+
+    return text;
+}
+
+FrameModelDiff FrameModelDiff::Compare(const FrameModel& oldFrameModel, const FrameModel& newFrameModel) {
+    PROFILE_SCOPE("FrameModelDiff::Compare");
+
+    FrameModelDiff frameModelDiff;
+
+    if (oldFrameModel.GetDigest() == newFrameModel.GetDigest())
+        return frameModelDiff;
+
+    for (int bucketIndex = 0; bucketIndex < FrameModel::GetDigestBucketsCount(); ++bucketIndex) {
+        if (oldFrameModel.GetBucketDigest(bucketIndex) == newFrameModel.GetBucketDigest(bucketIndex))
+            continue;
+
+        const auto& oldFrameDigests = oldFrameModel.GetBucketFrameDigests(bucketIndex);
+        const auto& newFrameDigests = newFrameModel.GetBucketFrameDigests(bucketIndex);
+
+        for (auto oldFrameDigestIt = oldFrameDigests.cbegin(); oldFrameDigestIt != oldFrameDigests.cend(); ++oldFrameDigestIt) {
+            const auto newFrameDigestIt = newFrameDigests.constFind(oldFrameDigestIt.key());
+
+            if (newFrameDigestIt == newFrameDigests.cend())
+                frameModelDiff.removedFrames.append(CompareFrames(&oldFrameModel, nullptr, oldFrameDigestIt.key()));
+            else if (newFrameDigestIt.value() != oldFrameDigestIt.value())
+                frameModelDiff.changedFrames.append(CompareFrames(&oldFrameModel, &newFrameModel, oldFrameDigestIt.key()));
+        }
+
+        for (auto newFrameDigestIt = newFrameDigests.cbegin(); newFrameDigestIt != newFrameDigests.cend(); ++newFrameDigestIt) {
+            if (!oldFrameDigests.contains(newFrameDigestIt.key()))
+                frameModelDiff.addedFrames.append(CompareFrames(nullptr, &newFrameModel, newFrameDigestIt.key()));
+        }
+    }
+
+    SortByFrameName(frameModelDiff.addedFrames);
+    SortByFrameName(frameModelDiff.removedFrames);
+    SortByFrameName(frameModelDiff.changedFrames);
+
+    return frameModelDiff;
+}
+
+QStringList FrameModelDiff::Merge(const FrameModel& baseFrameModel, FrameModel& ourFrameModel, const FrameModel& theirFrameModel) {
+    PROFILE_SCOPE("FrameModelDiff::Merge");
+
+    const auto theirDiff = Compare(baseFrameModel, theirFrameModel);
+    QStringList conflicts;
+    QVector<const FrameDifference*> mergedFrames;
+
+    // Сначала добавляются новые фреймы, чтобы слоты-фреймы могли на них ссылаться
+    for (const auto& frameDifference : theirDiff.addedFrames) {
+        if (!ourFrameModel.Contains(frameDifference.frameName)) {
+            ourFrameModel.AddFrame(Frame(frameDifference.frameName), frameDifference.newPosition);
+            mergedFrames.append(&frameDifference);
+        }
+        else if (ourFrameModel.GetFrameDigest(frameDifference.frameName) != theirFrameModel.GetFrameDigest(frameDifference.frameName)) {
+            conflicts.append(QString("Фрейм \"%1\" добавлен в обеих версиях по-разному").arg(frameDifference.frameName));
+        }
+    }
+
+    for (const auto& frameDifference : theirDiff.changedFrames) {
+        if (!ourFrameModel.Contains(frameDifference.frameName)) {
+            conflicts.append(QString("Фрейм \"%1\" удалён в нашей версии, но изменён в их версии").arg(frameDifference.frameName));
+            continue;
+        }
+
+        const auto ourFramePosition = ourFrameModel.GetPosition(ourFrameModel.Find(frameDifference.frameName));
+
+        if (ourFramePosition == frameDifference.oldPosition)
+            ourFrameModel.SetFramePosition(ourFrameModel.Find(frameDifference.frameName), frameDifference.newPosition);
+        else if (ourFramePosition != frameDifference.newPosition)
+            conflicts.append(QString("Фрейм \"%1\" перемещён в обеих версиях по-разному").arg(frameDifference.frameName));
+
+        mergedFrames.append(&frameDifference);
+    }
+
+    // Слот берётся из их версии, только если в нашей он остался таким же, как в базовой
+    for (const auto* frameDifference : qAsConst(mergedFrames)) {
+        const auto& frameName = frameDifference->frameName;
+
+        for (const auto& slotDifference : frameDifference->slotDifferences) {
+            const auto ourSlotState = GetSlotState(ourFrameModel.Get(ourFrameModel.Find(frameName)), slotDifference.slotName);
+
+            if (ourSlotState == slotDifference.newState)
+                continue;
+
+            if (ourSlotState != slotDifference.oldState) {
+                conflicts.append(QString("Слот \"%1\" фрейма \"%2\" изменён в обеих версиях по-разному").arg(slotDifference.slotName, frameName));
+                continue;
+            }
+
+            if (ourSlotState.isPresent)
+                ourFrameModel.EraseSlot(frameName, slotDifference.slotName);
+
+            if (slotDifference.newState.isFrameReference)
+                ourFrameModel.AddFrameReference(frameName, slotDifference.slotName);
+            else if (slotDifference.newState.isPresent)
+                ourFrameModel.AddSlot(frameName, ourFrameModel.Intern(slotDifference.slotName), ourFrameModel.Intern(slotDifference.newState.value));
+        }
+    }
+
+    // Удалённый в их версии фрейм удаляется, только если в нашей он не менялся
+    for (const auto& frameDifference : theirDiff.removedFrames) {
+        if (!ourFrameModel.Contains(frameDifference.frameName))
+            continue;
+
+        if (ourFrameModel.GetFrameDigest(frameDifference.frameName) == baseFrameModel.GetFrameDigest(frameDifference.frameName))
+            ourFrameModel.EraseFrame(frameDifference.frameName);
+        else
+            conflicts.append(QString("Фрейм \"%1\" изменён в нашей версии, но удалён в их версии").arg(frameDifference.frameName));
+    }
+
+    return conflicts;
+}
+
+FrameModelDiff::SlotState FrameModelDiff::GetSlotState(const Frame* frame, const QString& slotName) {
+    if (!frame)
+        return {};
+
+    const auto slotIt = frame->GetSlots().Find(slotName);
+    return slotIt != frame->GetSlots().end() ? ToSlotState(*slotIt) : SlotState();
+}
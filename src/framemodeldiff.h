@@ -0,0 +1,42 @@
+#ifndef FRAMEMODELDIFF_H
+#define FRAMEMODELDIFF_H
+
+#include "framemodel.h"
+
+// Различия двух версий модели. Сравниваются только корзины дайджеста, дайджесты которых различаются,
+// поэтому время сравнения определяется числом изменённых фреймов, а не размером моделей
+struct FrameModelDiff {
+    // Состояние слота в одной из версий: отсутствует, обычный слот со значением или слот-фрейм
+    struct SlotState {
+        bool isPresent = false, isFrameReference = false;
+        QString value;
+
+        bool operator==(const SlotState& other) const;
+        bool operator!=(const SlotState& other) const;
+    };
+
+    struct SlotDifference {
+        QString slotName;
+        SlotState oldState, newState;
+    };
+
+    struct FrameDifference {
+        QString frameName;
+        QPoint oldPosition, newPosition;
+        QVector<SlotDifference> slotDifferences; // Добавленные, удалённые и изменённые слоты
+    };
+
+    // У добавленных и удалённых фреймов все слоты считаются соответственно добавленными и удалёнными
+    QVector<FrameDifference> addedFrames, removedFrames, changedFrames;
+
+    bool IsEmpty() const;
+    QString ToText() const;
+
+    static FrameModelDiff Compare(const FrameModel& oldFrameModel, const FrameModel& newFrameModel);
+    // Трёхстороннее слияние: изменения base -> theirs применяются к ours. Если фрейм, его позиция или слот
+    // изменены в обеих версиях по-разному, остаётся вариант ours, а конфликт попадает в возвращаемый список
+    static QStringList Merge(const FrameModel& baseFrameModel, FrameModel& ourFrameModel, const FrameModel& theirFrameModel);
+    static SlotState GetSlotState(const Frame* frame, const QString& slotName);
+};
+
+#endif // FRAMEMODELDIFF_H
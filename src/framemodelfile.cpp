@@ -0,0 +1,133 @@
+#include "framemodelfile.h"
+#include "framemodel.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <algorithm>
+
+void FrameModelFile::ParseLine(const QString& line, FrameModelBatch& batch) {
+/* |  0  |    1   |  2 | 3 |    <--- Индексы в записи о фрейме
+ *  Фрейм Водитель 1125 150     <--- Так хранится в файле запись о фрейме
+ */
+
+/* |  0 |   1   |    2   |      3     |      4      |    5   |  <--- Индексы в записи о слоте
+ *  Слот Человек Значение Фрейм-ссылка Целевой_Фрейм Водитель   <--- Так хранится в файле запись о слоте-фрейме
+ *
+ * |  0 |     1    |    2   |  3 |      4      |                     5                    |  <--- Индексы в записи о слоте
+ *  Слот GPS-трекер Значение Есть Целевой_Фрейм Выделенная_для_перевозки_пассажиров_машина   <--- Так хранится в файле запись об обычном слоте
+ */
+
+    QStringList splitLine = line.split(' ');
+
+    if (splitLine[0] == "Фрейм" && splitLine.size() >= 4) {
+        batch.frameRecords.append({splitLine[1].replace('_', ' '), QPoint(splitLine[2].toInt(), splitLine[3].toInt())});
+    }
+    else if (splitLine[0] == "Слот" && splitLine.size() >= 6) {
+        const bool isFrameReference = splitLine[3] == "Фрейм-ссылка";
+
+        batch.slotRecords.append({splitLine[5].replace('_', ' '), splitLine[1].replace('_', ' '),
+                                  isFrameReference ? QString() : splitLine[3].replace('_', ' '), isFrameReference});
+    }
+}
+
+void FrameModelFile::WriteFrame(QTextStream& out, const Frame& frame, QPoint framePosition) {
+    out << QString::fromUtf8("Фрейм ") << QString(frame.GetName()).replace(' ', '_') << " " <<
+           QString::number(framePosition.x()) << ' ' << QString::number(framePosition.y()) << '\n';
+}
+
+void FrameModelFile::WriteSlots(QTextStream& out, const Frame& frame) {
+    const auto frameName = QString(frame.GetName()).replace(' ', '_');
+
+    for (const auto& [slotName, frameSlot] : frame.GetSlots()) {
+        QString slotValue;
+
+        if (std::holds_alternative<QString>(frameSlot))
+            slotValue = QString(std::get<QString>(frameSlot)).replace(' ', '_');
+        else
+            slotValue = QString::fromUtf8("Фрейм-ссылка");
+
+        out << QString::fromUtf8("Слот ") << QString(slotName).replace(' ', '_') <<
+               QString::fromUtf8(" Значение ") << slotValue <<
+               QString::fromUtf8(" Целевой_Фрейм ") << frameName << '\n';
+    }
+}
+
+void FrameModelFile::SortByFrameName(QVector<FrameHandle>& frameHandles, const FrameModel& frameModel) {
+    std::sort(frameHandles.begin(), frameHandles.end(), [&](FrameHandle left, FrameHandle right) {
+        return frameModel.Get(left)->GetName() < frameModel.Get(right)->GetName();
+    });
+}
+
+bool FrameModelFile::Load(const QString& filePath, FrameModel& frameModel) {
+    QFile file(filePath);
+
+    if (!file.open(QFile::ReadOnly))
+        return false;
+
+    QTextStream in(&file);
+    FrameModelBatch batch;
+
+    while (!in.atEnd()) {
+        ParseLine(in.readLine(), batch);
+    }
+
+    frameModel.Reserve(frameModel.Size() + batch.frameRecords.size());
+
+    for (const auto& frameRecord : qAsConst(batch.frameRecords)) {
+        frameModel.AddFrame(Frame(frameRecord.name), frameRecord.position);
+    }
+
+    for (const auto& slotRecord : qAsConst(batch.slotRecords)) {
+        if (!frameModel.Contains(slotRecord.targetFrameName))
+            continue;
+
+        if (slotRecord.isFrameReference) {
+            if (frameModel.Contains(slotRecord.slotName))
+                frameModel.AddFrameSlot(slotRecord.targetFrameName, slotRecord.slotName);
+        }
+        else {
+            frameModel.AddSlot(slotRecord.targetFrameName, frameModel.Intern(slotRecord.slotName), frameModel.Intern(slotRecord.slotValue));
+        }
+    }
+
+    return true;
+}
+
+bool FrameModelFile::Save(const QString& filePath, const FrameModel& frameModel) {
+    // Модель пишется во временный файл, который заменяет прежний только после успешной записи целиком:
+    // при нехватке места или ошибке ввода-вывода на диске остаётся прежняя версия, а Save возвращает false
+    QSaveFile file(filePath);
+
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QTextStream out(&file);
+    QVector<FrameHandle> frameHandles;
+    frameHandles.reserve(frameModel.Size());
+
+    frameModel.GetFramePool().ForEach([&](FrameHandle frameHandle, const FramePool::Entry&) {
+        frameHandles.append(frameHandle);
+    });
+
+    // Порядок записей в FramePool зависит от истории удалений, а не от содержимого модели
+    SortByFrameName(frameHandles, frameModel);
+
+    // Сначала сохранение просто всех фреймов
+    for (const auto frameHandle : qAsConst(frameHandles)) {
+        WriteFrame(out, *frameModel.Get(frameHandle), frameModel.GetPosition(frameHandle));
+    }
+
+    // Сохранение всех слотов всех фреймов
+    for (const auto frameHandle : qAsConst(frameHandles)) {
+        WriteSlots(out, *frameModel.Get(frameHandle));
+    }
+
+    out.flush();
+
+    if (out.status() != QTextStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
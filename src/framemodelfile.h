@@ -0,0 +1,45 @@
+#ifndef FRAMEMODELFILE_H
+#define FRAMEMODELFILE_H
+
+#include "frame.h"
+#include <QPoint>
+#include <QVector>
+
+class FrameModel;
+class QTextStream;
+
+// Разобранные строки файла модели
+struct FrameModelBatch {
+    struct FrameRecord {
+        QString name;
+        QPoint position;
+    };
+
+    struct SlotRecord {
+        QString targetFrameName;
+        QString slotName; // Для слота-фрейма — имя фрейма, на который он ссылается
+        QString slotValue;
+        bool isFrameReference = false;
+    };
+
+    QVector<FrameRecord> frameRecords;
+    QVector<SlotRecord> slotRecords;
+};
+
+// Текстовый формат файла модели (.fm): сначала строки всех фреймов, затем строки их слотов.
+// Фреймы записываются по возрастанию имён, а слоты фрейма — в порядке SlotTable, поэтому одинаковые модели
+// дают одинаковые файлы, сколько бы фреймов ни удалялось и ни создавалось в FramePool до сохранения.
+// Пробелы в именах и значениях хранятся как подчёркивания
+namespace FrameModelFile {
+    // Строки с недостающими полями пропускаются
+    void ParseLine(const QString& line, FrameModelBatch& batch);
+    void WriteFrame(QTextStream& out, const Frame& frame, QPoint framePosition);
+    void WriteSlots(QTextStream& out, const Frame& frame);
+    void SortByFrameName(QVector<FrameHandle>& frameHandles, const FrameModel& frameModel);
+    // Синхронная загрузка целого файла, без отображения (для инструментов командной строки).
+    // Слоты, целевого фрейма или фрейма-ссылки которых в файле нет, пропускаются
+    bool Load(const QString& filePath, FrameModel& frameModel);
+    bool Save(const QString& filePath, const FrameModel& frameModel);
+}
+
+#endif // FRAMEMODELFILE_H
@@ -0,0 +1,171 @@
+#include "framemodelhistory.h"
+#include "profiler.h"
+
+FrameModelHistory::Scope::Scope(FrameModelHistory* history, const QString& description) : _history(history)
+{
+    _history->BeginStep(description);
+}
+
+FrameModelHistory::Scope::~Scope() {
+    _history->EndStep();
+}
+
+FrameModelHistory::FrameModelHistory(FrameModel* frameModel, QObject* parent) : QObject(parent), _frameModel(frameModel)
+{
+    connect(_frameModel, &FrameModel::FrameAboutToChange, this, &FrameModelHistory::OnFrameAboutToChange);
+    connect(_frameModel, &FrameModel::ModelReset, this, &FrameModelHistory::Clear);
+}
+
+void FrameModelHistory::BeginStep(const QString& description) {
+    if (_stepDepth++ == 0)
+        _currentStep.description = description;
+}
+
+void FrameModelHistory::EndStep() {
+    if (--_stepDepth > 0)
+        return;
+
+    PROFILE_SCOPE("FrameModelHistory::EndStep");
+
+    auto step = std::move(_currentStep);
+    const auto oldDigests = std::move(_currentStepOldDigests);
+    _currentStep = Step();
+    _currentStepOldDigests.clear();
+
+    // Фреймы, вернувшиеся за шаг к исходному состоянию (или созданные и удалённые в нём), в шаг не попадают
+    for (auto frameChangeIt = step.frameChanges.begin(); frameChangeIt != step.frameChanges.end();) {
+        if (_frameModel->GetFrameDigest(frameChangeIt->frameName) == oldDigests.value(frameChangeIt->frameName)) {
+            frameChangeIt = step.frameChanges.erase(frameChangeIt);
+            continue;
+        }
+
+        frameChangeIt->newEntry = GetEntry(_frameModel->Find(frameChangeIt->frameName));
+        step.oldBytes += sizeof(FrameChange) + GetEntryBytes(frameChangeIt->oldEntry);
+        step.newBytes += sizeof(FrameChange) + GetEntryBytes(frameChangeIt->newEntry);
+        ++frameChangeIt;
+    }
+
+    if (step.frameChanges.isEmpty())
+        return;
+
+    // Новая правка делает отменённые шаги неповторяемыми
+    for (const auto& redoStep : qAsConst(_redoSteps)) {
+        _bytes -= redoStep.newBytes;
+    }
+
+    _redoSteps.clear();
+    _bytes += step.oldBytes;
+    _undoSteps.append(std::move(step));
+
+    UpdateCounters();
+    emit Changed();
+}
+
+bool FrameModelHistory::CanUndo() const {
+    return !_undoSteps.isEmpty() && _stepDepth == 0;
+}
+
+bool FrameModelHistory::CanRedo() const {
+    return !_redoSteps.isEmpty() && _stepDepth == 0;
+}
+
+QString FrameModelHistory::GetUndoDescription() const {
+    return _undoSteps.isEmpty() ? QString() : _undoSteps.last().description;
+}
+
+QString FrameModelHistory::GetRedoDescription() const {
+    return _redoSteps.isEmpty() ? QString() : _redoSteps.last().description;
+}
+
+void FrameModelHistory::Undo() {
+    if (!CanUndo())
+        return;
+
+    auto step = _undoSteps.takeLast();
+    Restore(step, true);
+
+    _bytes += step.newBytes - step.oldBytes;
+    _redoSteps.append(std::move(step));
+
+    UpdateCounters();
+    emit Changed();
+}
+
+void FrameModelHistory::Redo() {
+    if (!CanRedo())
+        return;
+
+    auto step = _redoSteps.takeLast();
+    Restore(step, false);
+
+    _bytes += step.oldBytes - step.newBytes;
+    _undoSteps.append(std::move(step));
+
+    UpdateCounters();
+    emit Changed();
+}
+
+void FrameModelHistory::Clear() {
+    // Открытый шаг (например, перетаскивание, прерванное загрузкой модели) остаётся открытым до своего EndStep,
+    // но правки из него к новой модели не относятся
+    _currentStep = Step();
+    _currentStepOldDigests.clear();
+    _undoSteps.clear();
+    _redoSteps.clear();
+    _bytes = 0;
+
+    UpdateCounters();
+    emit Changed();
+}
+
+int FrameModelHistory::GetUndoDepth() const {
+    return _undoSteps.size();
+}
+
+int FrameModelHistory::GetRedoDepth() const {
+    return _redoSteps.size();
+}
+
+qint64 FrameModelHistory::GetBytes() const {
+    return _bytes;
+}
+
+void FrameModelHistory::OnFrameAboutToChange(const QString& frameName, FrameHandle frameHandle) {
+    // Правки вне шагов (загрузка модели) в историю не попадают, а для фрейма запоминается версия до его первой правки в шаге
+    if (_stepDepth == 0 || _currentStepOldDigests.contains(frameName))
+        return;
+
+    _currentStepOldDigests.insert(frameName, _frameModel->GetFrameDigest(frameName));
+    _currentStep.frameChanges.append({frameName, GetEntry(frameHandle), std::nullopt});
+}
+
+std::optional<FramePool::Entry> FrameModelHistory::GetEntry(FrameHandle frameHandle) const {
+    if (const auto* frame = _frameModel->Get(frameHandle))
+        return FramePool::Entry{*frame, _frameModel->GetPosition(frameHandle)};
+
+    return std::nullopt;
+}
+
+void FrameModelHistory::Restore(const Step& step, bool isUndo) {
+    PROFILE_SCOPE("FrameModelHistory::Restore");
+
+    // Ссылки между фреймами шага восстанавливаются по именам, поэтому порядок восстановления не важен
+    for (const auto& frameChange : step.frameChanges) {
+        const auto& restoredEntry = isUndo ? frameChange.oldEntry : frameChange.newEntry;
+        _frameModel->RestoreFrame(frameChange.frameName, restoredEntry ? &restoredEntry.value() : nullptr);
+    }
+}
+
+void FrameModelHistory::UpdateCounters() {
+    PROFILE_COUNTER("История правок: шагов отмены", _undoSteps.size());
+    PROFILE_COUNTER("История правок: шагов повтора", _redoSteps.size());
+    PROFILE_COUNTER("История правок: память, байт", _bytes);
+}
+
+qint64 FrameModelHistory::GetEntryBytes(const std::optional<FramePool::Entry>& entry) {
+    if (!entry)
+        return 0;
+
+    const auto& frameSlots = entry->frame.GetSlots();
+    return sizeof(FramePool::Entry) + frameSlots.GetSlotsBytes() + frameSlots.GetIndexBytes();
+}
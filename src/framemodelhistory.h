@@ -0,0 +1,75 @@
+#ifndef FRAMEMODELHISTORY_H
+#define FRAMEMODELHISTORY_H
+
+#include "framemodel.h"
+#include <optional>
+
+// Неограниченная история правок модели для отмены и повтора. Шаг хранит версии до и после шага только
+// для изменённых им фреймов (по сигналу FrameModel::FrameAboutToChange), а остальные фреймы в нём
+// не участвуют. Имя и слоты фрейма — неявно разделяемые QString и QVector, поэтому версия фрейма в истории
+// копируется за O(1) и делит память с фреймом модели, пока тот не изменится (копирование при записи),
+// а версия после одного шага — с версией до следующего. Так каждый шаг стоит памяти и времени
+// пропорционально изменённым фреймам, а не всей модели
+class FrameModelHistory : public QObject {
+    Q_OBJECT
+
+public:
+    // Шаг истории на время жизни объекта: все правки модели внутри него отменяются вместе.
+    // Вложенные шаги сливаются с внешним
+    class Scope {
+    public:
+        Scope(FrameModelHistory* history, const QString& description);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameModelHistory* _history;
+    };
+
+    explicit FrameModelHistory(FrameModel* frameModel, QObject* parent = nullptr);
+    void BeginStep(const QString& description);
+    void EndStep();
+    bool CanUndo() const;
+    bool CanRedo() const;
+    QString GetUndoDescription() const;
+    QString GetRedoDescription() const;
+    void Undo();
+    void Redo();
+    void Clear();
+    int GetUndoDepth() const;
+    int GetRedoDepth() const;
+    qint64 GetBytes() const;
+
+signals:
+    void Changed();
+
+private:
+    struct FrameChange {
+        QString frameName;
+        std::optional<FramePool::Entry> oldEntry, newEntry; // Нет значения — фрейма до шага не было / после шага не стало
+    };
+
+    struct Step {
+        QString description;
+        QVector<FrameChange> frameChanges;
+        // Память, которую занимают только версии из истории: у шагов отмены это версии до шага,
+        // у шагов повтора — после (другие версии делятся с моделью или соседними шагами)
+        qint64 oldBytes = 0, newBytes = 0;
+    };
+
+    FrameModel* _frameModel;
+    QVector<Step> _undoSteps, _redoSteps;
+    Step _currentStep;
+    QHash<QString, quint64> _currentStepOldDigests; // [FrameName, FrameDigest] фреймов, изменённых в текущем шаге
+    int _stepDepth = 0;
+    qint64 _bytes = 0;
+
+    void OnFrameAboutToChange(const QString& frameName, FrameHandle frameHandle);
+    std::optional<FramePool::Entry> GetEntry(FrameHandle frameHandle) const;
+    void Restore(const Step& step, bool isUndo);
+    void UpdateCounters();
+    static qint64 GetEntryBytes(const std::optional<FramePool::Entry>& entry);
+};
+
+#endif // FRAMEMODELHISTORY_H
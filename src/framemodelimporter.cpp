@@ -0,0 +1,555 @@
+#include "framemodelimporter.h"
+#include "framemodel.h"
+#include "profiler.h"
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace {
+    constexpr qint64 chunkBytes = 1 << 20;
+    constexpr int batchRowsCount = 4096;
+    // Незакрытая кавычка не должна затянуть в одно поле весь остаток файла: поле длиннее maxFieldBytes
+    // или запись длиннее maxRecordLines строк обрывается, и чтение продолжается со следующей строки
+    constexpr int maxFieldBytes = 1 << 20;
+    constexpr int maxRecordLines = 100;
+    // Сетка, по которой раскладываются новые фреймы без координат; координаты холста — четырёхзначные
+    constexpr int layoutColumnsCount = 40;
+    constexpr int layoutStepX = 250, layoutStepY = 120;
+    constexpr int maxCoordinate = 9999;
+
+    // Потоковое чтение записей CSV по RFC 4180: поля в кавычках могут содержать разделитель, перевод строки
+    // и удвоенную кавычку. В памяти находится только текущая часть файла и текущая запись не длиннее maxFieldBytes
+    // на поле
+    class TableReader {
+    public:
+        explicit TableReader(QIODevice* device) : _device(device) {}
+
+        // Разделитель — тот из ',', ';' и '\t', что чаще встречается в первой строке вне кавычек
+        void DetectDelimiter() {
+            if (!HasData())
+                return;
+
+            if (_buffer.startsWith("\xEF\xBB\xBF"))
+                _position = 3;
+
+            int commasCount = 0, semicolonsCount = 0, tabsCount = 0;
+            bool isQuoted = false;
+
+            for (int position = _position; position < _buffer.size() && (isQuoted || _buffer.at(position) != '\n'); ++position) {
+                switch (_buffer.at(position)) {
+                case '"':
+                    isQuoted = !isQuoted;
+                    break;
+                case ',':
+                    commasCount += !isQuoted;
+                    break;
+                case ';':
+                    semicolonsCount += !isQuoted;
+                    break;
+                case '\t':
+                    tabsCount += !isQuoted;
+                    break;
+                }
+            }
+
+            if (tabsCount > commasCount && tabsCount >= semicolonsCount)
+                _delimiter = '\t';
+            else if (semicolonsCount > commasCount)
+                _delimiter = ';';
+        }
+
+        // Следующая запись таблицы и номер строки файла, с которой она начинается, или false в конце файла
+        bool ReadRecord(QStringList& cells, int& lineNumber) {
+            cells.clear();
+            _isRecordMalformed = false;
+
+            if (!HasData())
+                return false;
+
+            lineNumber = _lineNumber;
+            auto state = State::FieldStart;
+            _field.clear();
+
+            char c = 0;
+
+            while (HasData()) {
+                c = _buffer.at(_position++);
+
+                if (state == State::Quoted) {
+                    if (c == '"') {
+                        state = State::QuoteInQuoted;
+                        continue;
+                    }
+
+                    _field.append(c);
+
+                    if (c == '\n' && ++_lineNumber - lineNumber >= maxRecordLines)
+                        return FinishMalformedRecord(cells, c, false);
+
+                    if (_field.size() > maxFieldBytes)
+                        return FinishMalformedRecord(cells, c, true);
+
+                    continue;
+                }
+
+                // Удвоенная кавычка внутри кавычек — сама кавычка, а одиночная закрывает поле
+                if (state == State::QuoteInQuoted) {
+                    if (c == '"') {
+                        _field.append(c);
+                        state = State::Quoted;
+                        continue;
+                    }
+
+                    state = State::Unquoted;
+                }
+
+                if (c == _delimiter) {
+                    cells.append(QString::fromUtf8(_field));
+                    _field.clear();
+                    state = State::FieldStart;
+                }
+                else if (c == '\n') {
+                    ++_lineNumber;
+                    cells.append(QString::fromUtf8(_field));
+                    return true;
+                }
+                else if (c == '"' && state == State::FieldStart) {
+                    state = State::Quoted;
+                }
+                else if (c != '\r') {
+                    _field.append(c);
+                    state = State::Unquoted;
+
+                    if (_field.size() > maxFieldBytes)
+                        return FinishMalformedRecord(cells, c, true);
+                }
+            }
+
+            // Последняя строка файла без перевода строки
+            if (state == State::Quoted)
+                return FinishMalformedRecord(cells, c, false);
+
+            cells.append(QString::fromUtf8(_field));
+            return true;
+        }
+
+        // Последняя запись с незакрытой кавычкой или слишком длинным полем: её ячейки не прочитаны
+        bool IsRecordMalformed() const {
+            return _isRecordMalformed;
+        }
+
+        // Номер последней строки файла, занятой неправильной записью
+        int GetRecordLastLineNumber() const {
+            return _recordLastLineNumber;
+        }
+
+        bool HasError() const {
+            return _hasError;
+        }
+
+    private:
+        enum class State { FieldStart, Unquoted, Quoted, QuoteInQuoted };
+
+        QIODevice* _device;
+        QByteArray _buffer, _field;
+        int _position = 0;
+        int _lineNumber = 1, _recordLastLineNumber = 0;
+        char _delimiter = ',';
+        bool _isRecordMalformed = false, _hasError = false;
+
+        // lastChar — последний прочитанный символ записи: после перевода строки _lineNumber уже указывает на следующую
+        bool FinishMalformedRecord(QStringList& cells, char lastChar, bool needsToSkipLine) {
+            cells.clear();
+            _field.clear();
+            _isRecordMalformed = true;
+
+            // Остаток строки, на которой оборвалось поле, пропускается вместе с ним
+            while (needsToSkipLine && lastChar != '\n' && HasData()) {
+                lastChar = _buffer.at(_position++);
+                _lineNumber += lastChar == '\n';
+            }
+
+            _recordLastLineNumber = lastChar == '\n' ? _lineNumber - 1 : _lineNumber;
+            return true;
+        }
+
+        bool HasData() {
+            if (_position < _buffer.size())
+                return true;
+
+            _buffer.resize(chunkBytes);
+            const auto readBytes = _device->read(_buffer.data(), chunkBytes);
+
+            if (readBytes < 0)
+                _hasError = true;
+
+            _buffer.resize(static_cast<int>(qMax<qint64>(readBytes, 0)));
+            _position = 0;
+            return !_buffer.isEmpty();
+        }
+    };
+
+    struct Column {
+        enum class Kind { FrameName, X, Y, Slot, Reference, Ignored };
+
+        Kind kind;
+        QString slotName;
+    };
+
+    struct Row {
+        int lineNumber;
+        QStringList cells;
+        QPoint position;
+        bool hasPosition = false, isValid = true;
+    };
+
+    bool ContainsLineBreak(const QString& text) {
+        return text.contains('\n') || text.contains('\r');
+    }
+
+    // Проверка и применение строк таблицы: строки копятся пачками, пачка сначала проверяется целиком,
+    // а затем применяется к модели через BulkUpdate
+    class TableImport {
+    public:
+        TableImport(FrameModel& frameModel, FrameModelImport& import) : _frameModel(frameModel), _import(import), _bulkUpdate(&frameModel) {}
+
+        // Замечания приходят не по порядку строк: ошибки разбора — при чтении, ошибки проверки — после заполнения
+        // пачки, а неразрешённые ссылки — в конце. Поэтому хранятся maxFindingsCount замечаний с наименьшими
+        // номерами строк (куча с наибольшим номером в вершине), а остальные только подсчитываются
+        void AddFinding(int lineNumber, FrameModelImport::Severity severity, const QString& message) {
+            const PendingFinding pendingFinding{{lineNumber, severity, message}, _findingsCount++};
+
+            if (static_cast<int>(_pendingFindings.size()) < FrameModelImport::maxFindingsCount) {
+                _pendingFindings.push_back(pendingFinding);
+                std::push_heap(_pendingFindings.begin(), _pendingFindings.end());
+                return;
+            }
+
+            ++_import.omittedFindingsCount;
+
+            if (pendingFinding < _pendingFindings.front()) {
+                std::pop_heap(_pendingFindings.begin(), _pendingFindings.end());
+                _pendingFindings.back() = pendingFinding;
+                std::push_heap(_pendingFindings.begin(), _pendingFindings.end());
+            }
+        }
+
+        void TakeFindings() {
+            std::sort_heap(_pendingFindings.begin(), _pendingFindings.end());
+
+            for (auto& pendingFinding : _pendingFindings) {
+                _import.findings.append(std::move(pendingFinding.finding));
+            }
+
+            _pendingFindings.clear();
+        }
+
+        void ReadHeader(const QStringList& headerCells) {
+            _columns.append({Column::Kind::FrameName, QString()});
+
+            for (int columnIndex = 1; columnIndex < headerCells.size(); ++columnIndex) {
+                const auto header = headerCells[columnIndex].trimmed();
+                auto column = Column{Column::Kind::Ignored, QString()};
+
+                if (header.compare("x", Qt::CaseInsensitive) == 0 && _xColumnIndex < 0) {
+                    column.kind = Column::Kind::X;
+                    _xColumnIndex = columnIndex;
+                }
+                else if (header.compare("y", Qt::CaseInsensitive) == 0 && _yColumnIndex < 0) {
+                    column.kind = Column::Kind::Y;
+                    _yColumnIndex = columnIndex;
+                }
+                else if (header.startsWith('@')) {
+                    column.kind = Column::Kind::Reference;
+                }
+                else if (header.isEmpty() || ContainsLineBreak(header)) {
+                    AddFinding(1, FrameModelImport::Severity::Warning, QString("колонка %1 без имени слота пропущена").arg(columnIndex + 1));
+                }
+                else if (std::any_of(_columns.cbegin(), _columns.cend(), [&](const Column& otherColumn) { return otherColumn.slotName == header; })) {
+                    AddFinding(1, FrameModelImport::Severity::Warning, QString("колонка %1: слот \"%2\" уже задан, колонка пропущена").arg(columnIndex + 1).arg(header));
+                }
+                // Как и в редакторе, имя обычного слота не должно совпадать с именем фрейма
+                else if (_frameModel.Contains(header)) {
+                    AddFinding(1, FrameModelImport::Severity::Error, QString("колонка %1: \"%2\" — имя фрейма модели, а не слота, колонка пропущена").arg(columnIndex + 1).arg(header));
+                }
+                else {
+                    column.kind = Column::Kind::Slot;
+                    column.slotName = _frameModel.Intern(header);
+                }
+
+                _columns.append(column);
+            }
+
+            // Без одной из координат другая тоже не используется
+            if ((_xColumnIndex < 0) != (_yColumnIndex < 0)) {
+                AddFinding(1, FrameModelImport::Severity::Warning, "задана только одна из колонок \"x\" и \"y\": координаты не импортируются");
+                _xColumnIndex = _yColumnIndex = -1;
+            }
+        }
+
+        void AddRow(int lineNumber, const QStringList& cells) {
+            _rows.append({lineNumber, cells});
+
+            if (_rows.size() == batchRowsCount)
+                Flush();
+        }
+
+        void Flush() {
+            ValidateBatch();
+            ApplyBatch();
+            _rows.clear();
+        }
+
+        void Commit() {
+            // Ссылки на фреймы, которых нет ни в модели, ни в таблице, не сохраняются: проверка файла модели сочла бы их ошибкой
+            for (auto missingReferenceIt = _missingReferences.cbegin(); missingReferenceIt != _missingReferences.cend(); ++missingReferenceIt) {
+                for (const auto& [frameHandle, lineNumber] : missingReferenceIt.value()) {
+                    _bulkUpdate.EraseFrameReference(frameHandle, missingReferenceIt.key());
+                    --_import.referencesCount;
+                    AddFinding(lineNumber, FrameModelImport::Severity::Error,
+                               "фрейма \"" + missingReferenceIt.key() + "\" нет ни в модели, ни в таблице: ссылка пропущена");
+                }
+            }
+
+            _bulkUpdate.Commit();
+            _import.isCommitted = true;
+        }
+
+    private:
+        struct PendingFinding {
+            FrameModelImport::Finding finding;
+            int sequence; // Среди замечаний к одной строке сохраняется порядок их появления
+
+            bool operator<(const PendingFinding& other) const {
+                return std::tie(finding.lineNumber, sequence) < std::tie(other.finding.lineNumber, other.sequence);
+            }
+        };
+
+        FrameModel& _frameModel;
+        FrameModelImport& _import;
+        std::vector<PendingFinding> _pendingFindings;
+        int _findingsCount = 0;
+        FrameModel::BulkUpdate _bulkUpdate;
+        QVector<Column> _columns;
+        int _xColumnIndex = -1, _yColumnIndex = -1;
+        QVector<Row> _rows;
+        // [FrameName, [фрейм со ссылкой, номер строки]] для ссылок на фреймы, которых пока нет в модели.
+        // Единственное, что растёт с таблицей: ссылка ждёт, пока фрейм не встретится в следующих строках
+        QHash<QString, QVector<QPair<FrameHandle, int>>> _missingReferences;
+        int _autoPlacedFramesCount = 0;
+
+        bool IsSlotColumnName(const QString& name) const {
+            return std::any_of(_columns.cbegin(), _columns.cend(), [&](const Column& column) {
+                return column.kind == Column::Kind::Slot && column.slotName == name;
+            });
+        }
+
+        void ValidateBatch() {
+            PROFILE_SCOPE("FrameModelImporter::ValidateBatch");
+
+            for (auto& row : _rows) {
+                if (row.cells.size() > _columns.size()) {
+                    AddFinding(row.lineNumber, FrameModelImport::Severity::Error,
+                               QString("ячеек %1, а колонок в заголовке %2: строка пропущена").arg(row.cells.size()).arg(_columns.size()));
+                    row.isValid = false;
+                    continue;
+                }
+
+                // Недостающие ячейки в конце строки считаются пустыми
+                while (row.cells.size() < _columns.size()) {
+                    row.cells.append(QString());
+                }
+
+                row.cells[0] = row.cells[0].trimmed();
+
+                if (row.cells[0].isEmpty() || ContainsLineBreak(row.cells[0])) {
+                    AddFinding(row.lineNumber, FrameModelImport::Severity::Error, "пустое или многострочное имя фрейма: строка пропущена");
+                    row.isValid = false;
+                    continue;
+                }
+
+                if (IsSlotColumnName(row.cells[0])) {
+                    AddFinding(row.lineNumber, FrameModelImport::Severity::Error,
+                               "имя фрейма \"" + row.cells[0] + "\" совпадает с колонкой-слотом: строка пропущена");
+                    row.isValid = false;
+                    continue;
+                }
+
+                if (_xColumnIndex >= 0) {
+                    bool isXValid = false, isYValid = false;
+                    row.position = QPoint(row.cells[_xColumnIndex].trimmed().toInt(&isXValid), row.cells[_yColumnIndex].trimmed().toInt(&isYValid));
+                    row.hasPosition = isXValid && isYValid && row.position.x() >= 0 && row.position.x() <= maxCoordinate &&
+                                      row.position.y() >= 0 && row.position.y() <= maxCoordinate;
+
+                    if (!row.hasPosition)
+                        AddFinding(row.lineNumber, FrameModelImport::Severity::Warning, "координаты фрейма не заданы или вне холста: фрейм размещён автоматически");
+                }
+
+                for (int columnIndex = 1; columnIndex < _columns.size(); ++columnIndex) {
+                    auto& cell = row.cells[columnIndex];
+
+                    if (_columns[columnIndex].kind == Column::Kind::Reference)
+                        cell = cell.trimmed();
+                    else if (_columns[columnIndex].kind != Column::Kind::Slot)
+                        continue;
+
+                    // Файл модели хранит по записи на строке, поэтому перевод строки в нём не сохранится
+                    if (ContainsLineBreak(cell)) {
+                        AddFinding(row.lineNumber, FrameModelImport::Severity::Error, QString("колонка %1: значение в несколько строк пропущено").arg(columnIndex + 1));
+                        cell.clear();
+                    }
+                    else if (_columns[columnIndex].kind == Column::Kind::Reference && cell == row.cells[0]) {
+                        AddFinding(row.lineNumber, FrameModelImport::Severity::Error, QString("колонка %1: фрейм не может ссылаться на себя").arg(columnIndex + 1));
+                        cell.clear();
+                    }
+                    // Такой фрейм не может появиться (см. выше), а слот-фрейм заменил бы одноимённый обычный слот строки
+                    else if (_columns[columnIndex].kind == Column::Kind::Reference && IsSlotColumnName(cell)) {
+                        AddFinding(row.lineNumber, FrameModelImport::Severity::Error,
+                                   QString("колонка %1: \"%2\" — имя колонки-слота, а не фрейма, ссылка пропущена").arg(columnIndex + 1).arg(cell));
+                        cell.clear();
+                    }
+                }
+            }
+        }
+
+        void ApplyBatch() {
+            PROFILE_SCOPE("FrameModelImporter::ApplyBatch");
+
+            for (const auto& row : qAsConst(_rows)) {
+                if (!row.isValid)
+                    continue;
+
+                const auto& frameName = row.cells[0];
+                const auto existingFrameHandle = _frameModel.Find(frameName);
+                auto framePosition = row.position;
+
+                if (!row.hasPosition && !existingFrameHandle.IsNull()) {
+                    framePosition = _frameModel.GetPosition(existingFrameHandle);
+                }
+                else if (!row.hasPosition) {
+                    framePosition = QPoint(_autoPlacedFramesCount % layoutColumnsCount * layoutStepX,
+                                           _autoPlacedFramesCount / layoutColumnsCount * layoutStepY % (maxCoordinate + 1 - layoutStepY));
+                    ++_autoPlacedFramesCount;
+                }
+
+                const auto frameHandle = _bulkUpdate.AddFrame(frameName, framePosition);
+                _import.framesCount += existingFrameHandle.IsNull();
+                ++_import.importedRowsCount;
+                _missingReferences.remove(frameName);
+
+                for (int columnIndex = 1; columnIndex < _columns.size(); ++columnIndex) {
+                    const auto& cell = row.cells[columnIndex];
+
+                    if (cell.isEmpty())
+                        continue;
+
+                    if (_columns[columnIndex].kind == Column::Kind::Slot) {
+                        _bulkUpdate.AddSlot(frameHandle, _columns[columnIndex].slotName, _frameModel.Intern(cell));
+                        ++_import.slotsCount;
+                    }
+                    else if (_columns[columnIndex].kind == Column::Kind::Reference) {
+                        const auto& frameSlots = _frameModel.Get(frameHandle)->GetSlots();
+                        const auto existingSlotIt = frameSlots.Find(cell);
+
+                        if (existingSlotIt != frameSlots.end() && std::holds_alternative<QString>(existingSlotIt->value)) {
+                            AddFinding(row.lineNumber, FrameModelImport::Severity::Error,
+                                       QString("колонка %1: у фрейма уже есть обычный слот \"%2\", ссылка пропущена").arg(columnIndex + 1).arg(cell));
+                            continue;
+                        }
+
+                        if (_frameModel.Find(cell).IsNull())
+                            _missingReferences[cell].append(qMakePair(frameHandle, row.lineNumber));
+
+                        _bulkUpdate.AddFrameReference(frameHandle, _frameModel.Intern(cell));
+                        ++_import.referencesCount;
+                    }
+                }
+            }
+        }
+    };
+}
+
+int FrameModelImport::GetErrorsCount() const {
+    return static_cast<int>(std::count_if(findings.cbegin(), findings.cend(), [](const Finding& finding) {
+        return finding.severity == Severity::Error;
+    }));
+}
+
+QString FrameModelImport::ToText() const {
+    QString text;
+
+    for (const auto& finding : findings) {
+        text += QString("Строка %1: %2: %3\n").arg(finding.lineNumber).
+                arg(QString(finding.severity == Severity::Error ? "ошибка" : "предупреждение"), finding.message);
+    }
+
+    if (omittedFindingsCount > 0)
+        text += QString("И ещё замечаний: %1\n").arg(omittedFindingsCount);
+
+    text += QString("Строк таблицы: %1, импортировано: %2, новых фреймов: %3, слотов: %4, слотов-фреймов: %5\n").
+            arg(rowsCount).arg(importedRowsCount).arg(framesCount).arg(slotsCount).arg(referencesCount);
+
+    if (!isCommitted)
+        text += "Модель не изменена\n";
+
+    return text;
+}
+
+FrameModelImport FrameModelImporter::Import(const QString& filePath, FrameModel& frameModel) {
+    PROFILE_SCOPE("FrameModelImporter::Import");
+
+    FrameModelImport import;
+    QFile file(filePath);
+
+    if (!file.open(QFile::ReadOnly))
+        return import;
+
+    import.isFileOpened = true;
+
+    TableReader tableReader(&file);
+    tableReader.DetectDelimiter();
+
+    QStringList cells;
+    int lineNumber = 0;
+
+    if (!tableReader.ReadRecord(cells, lineNumber) || tableReader.IsRecordMalformed()) {
+        import.findings.append({0, FrameModelImport::Severity::Error, "в таблице нет заголовка"});
+        return import;
+    }
+
+    // Пока TableImport не подтвердил пакет, его деструктор откатывает изменения модели
+    TableImport tableImport(frameModel, import);
+    tableImport.ReadHeader(cells);
+
+    while (tableReader.ReadRecord(cells, lineNumber)) {
+        if (tableReader.IsRecordMalformed()) {
+            ++import.rowsCount;
+            tableImport.AddFinding(lineNumber, FrameModelImport::Severity::Error,
+                                   QString("незакрытая кавычка или поле длиннее %1 байт: пропущены строки %2–%3").
+                                   arg(maxFieldBytes).arg(lineNumber).arg(tableReader.GetRecordLastLineNumber()));
+            continue;
+        }
+
+        if (cells.size() == 1 && cells[0].isEmpty())
+            continue;
+
+        ++import.rowsCount;
+
+        tableImport.AddRow(lineNumber, cells);
+    }
+
+    if (tableReader.HasError()) {
+        tableImport.AddFinding(0, FrameModelImport::Severity::Error, "не удалось дочитать файл: " + file.errorString());
+    }
+    else {
+        tableImport.Flush();
+        tableImport.Commit();
+    }
+
+    tableImport.TakeFindings();
+
+    PROFILE_COUNTER("Импорт таблицы: слотов", import.slotsCount + import.referencesCount);
+    return import;
+}
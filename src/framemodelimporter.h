@@ -0,0 +1,46 @@
+#ifndef FRAMEMODELIMPORTER_H
+#define FRAMEMODELIMPORTER_H
+
+#include <QString>
+#include <QVector>
+
+class FrameModel;
+
+// Результат импорта таблицы
+struct FrameModelImport {
+    // Ошибочные строки и ячейки пропускаются, предупреждения только сообщаются
+    enum class Severity { Warning, Error };
+
+    struct Finding {
+        int lineNumber; // 0 — замечание ко всей таблице
+        Severity severity;
+        QString message;
+    };
+
+    QVector<Finding> findings; // По возрастанию номеров строк, не больше maxFindingsCount самых ранних
+    int omittedFindingsCount = 0; // Замечания сверх maxFindingsCount только подсчитываются
+    int rowsCount = 0, importedRowsCount = 0, framesCount = 0, slotsCount = 0, referencesCount = 0; // framesCount — новые фреймы
+    bool isFileOpened = false, isCommitted = false;
+
+    inline static constexpr int maxFindingsCount = 1000;
+
+    int GetErrorsCount() const;
+    QString ToText() const;
+};
+
+// Импорт таблицы CSV или TSV в модель: каждая строка таблицы становится фреймом, а колонки — его слотами.
+// В первой колонке — имя фрейма, колонки "x" и "y" задают его координаты (без них новые фреймы
+// раскладываются сеткой, а существующие остаются на месте), колонка с заголовком "@..." — слот-фрейм,
+// ссылающийся на фрейм, имя которого записано в ячейке, а остальные колонки — обычные слоты с именем
+// из заголовка и значением из ячейки; пустые ячейки слотов не создают. Разделитель (запятая, точка с запятой
+// или табуляция) определяется по заголовку. Слоты фрейма, который уже есть в модели, добавляются к его слотам.
+// Ссылки на себя и на фреймы, которых нет ни в модели, ни в таблице, а также колонки и фреймы, чьё имя
+// совпало бы с именем слота, пропускаются с ошибкой, поэтому проверка сохранённой модели их не находит.
+// Файл читается потоком по частям, а строки проверяются и применяются пачками через FrameModel::BulkUpdate,
+// поэтому память растёт только со ссылками на ещё не встретившиеся фреймы, а модель получает один сигнал на весь импорт.
+// Если файл не удалось прочитать до конца, модель остаётся прежней
+namespace FrameModelImporter {
+    FrameModelImport Import(const QString& filePath, FrameModel& frameModel);
+}
+
+#endif // FRAMEMODELIMPORTER_H
@@ -0,0 +1,138 @@
+#include "framemodelloader.h"
+#include "profiler.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+FrameModelLoader::FrameModelLoader(QObject* parent) : QObject(parent)
+{
+    _deliveryTimer.setInterval(_deliveryIntervalMs);
+    connect(&_deliveryTimer, &QTimer::timeout, this, &FrameModelLoader::DeliverBatches);
+}
+
+FrameModelLoader::~FrameModelLoader() {
+    StopParserThread();
+}
+
+void FrameModelLoader::Start(const QString& filePath) {
+    Cancel();
+
+    _isCancelled = false;
+    _isParsingFinished = false;
+    _isFileOpened = false;
+
+    _parserThread = QThread::create([=]() { Parse(filePath); });
+    _parserThread->start();
+    _deliveryTimer.start();
+}
+
+void FrameModelLoader::Cancel() {
+    _deliveryTimer.stop();
+    StopParserThread();
+    _batches.clear();
+}
+
+bool FrameModelLoader::IsLoading() const {
+    return _deliveryTimer.isActive();
+}
+
+void FrameModelLoader::Parse(const QString& filePath) {
+    PROFILE_SCOPE("FrameModelLoader::Parse");
+
+    QFile file(filePath);
+
+    if (!file.open(QFile::ReadOnly)) {
+        FinishParsing(false);
+        return;
+    }
+
+    QTextStream in(&file);
+    FrameModelBatch batch;
+    int batchLinesCount = 0;
+
+    while (!in.atEnd() && !_isCancelled) {
+        FrameModelFile::ParseLine(in.readLine(), batch);
+
+        if (++batchLinesCount == _batchLinesCount) {
+            if (!Enqueue(std::move(batch)))
+                return;
+
+            batch = FrameModelBatch();
+            batchLinesCount = 0;
+        }
+    }
+
+    if (batchLinesCount > 0 && !Enqueue(std::move(batch)))
+        return;
+
+    FinishParsing(true);
+}
+
+bool FrameModelLoader::Enqueue(FrameModelBatch&& batch) {
+    QMutexLocker locker(&_mutex);
+
+    // Если поток GUI не успевает применять порции, разбор приостанавливается, чтобы очередь не росла без предела
+    while (_batches.size() >= _maxQueuedBatches && !_isCancelled) {
+        _queueNotFull.wait(&_mutex);
+    }
+
+    if (_isCancelled)
+        return false;
+
+    _batches.enqueue(std::move(batch));
+    return true;
+}
+
+void FrameModelLoader::FinishParsing(bool isFileOpened) {
+    QMutexLocker locker(&_mutex);
+    _isFileOpened = isFileOpened;
+    _isParsingFinished = true;
+}
+
+void FrameModelLoader::DeliverBatches() {
+    QElapsedTimer deliveryTimer;
+    deliveryTimer.start();
+
+    while (deliveryTimer.elapsed() < _deliveryBudgetMs) {
+        FrameModelBatch batch;
+
+        {
+            QMutexLocker locker(&_mutex);
+
+            if (_batches.isEmpty()) {
+                if (!_isParsingFinished)
+                    return;
+
+                _deliveryTimer.stop();
+                const bool isFileOpened = _isFileOpened;
+                locker.unlock();
+
+                StopParserThread();
+                emit Finished(isFileOpened);
+                return;
+            }
+
+            batch = _batches.dequeue();
+            _queueNotFull.wakeOne();
+        }
+
+        PROFILE_SCOPE("FrameModelLoader::DeliverBatch");
+        emit BatchLoaded(batch);
+    }
+}
+
+void FrameModelLoader::StopParserThread() {
+    if (!_parserThread)
+        return;
+
+    {
+        QMutexLocker locker(&_mutex);
+        _isCancelled = true;
+        _queueNotFull.wakeAll();
+    }
+
+    _parserThread->wait();
+    delete _parserThread;
+    _parserThread = nullptr;
+}
@@ -0,0 +1,53 @@
+#ifndef FRAMEMODELLOADER_H
+#define FRAMEMODELLOADER_H
+
+#include "framemodelfile.h"
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QWaitCondition>
+#include <atomic>
+
+class QThread;
+
+// Фоновая загрузка файла модели. Строки разбираются в отдельном потоке и порциями складываются
+// в ограниченную очередь, а в потоке GUI порции выдаются сигналом BatchLoaded по таймеру и не дольше
+// _deliveryBudgetMs за раз, поэтому окно показывается сразу и успевает перерисовываться между порциями
+class FrameModelLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FrameModelLoader(QObject* parent = nullptr);
+    ~FrameModelLoader();
+    void Start(const QString& filePath);
+    void Cancel();
+    bool IsLoading() const;
+
+signals:
+    void BatchLoaded(const FrameModelBatch& batch);
+    // Испускается после последней порции. isFileOpened == false, если файл открыть не удалось
+    void Finished(bool isFileOpened);
+
+private:
+    QThread* _parserThread = nullptr;
+    QTimer _deliveryTimer;
+    QMutex _mutex;
+    QWaitCondition _queueNotFull;
+    QQueue<FrameModelBatch> _batches;
+    bool _isParsingFinished = false, _isFileOpened = false;
+    std::atomic_bool _isCancelled {false};
+
+    inline static constexpr int _batchLinesCount = 2048;
+    inline static constexpr int _maxQueuedBatches = 64;
+    inline static constexpr int _deliveryIntervalMs = 16;
+    inline static constexpr int _deliveryBudgetMs = 8;
+
+    void Parse(const QString& filePath);
+    bool Enqueue(FrameModelBatch&& batch);
+    void FinishParsing(bool isFileOpened);
+    void DeliverBatches();
+    void StopParserThread();
+};
+
+#endif // FRAMEMODELLOADER_H
@@ -0,0 +1,86 @@
+#include "framemodelprotocol.h"
+
+namespace {
+    const QByteArray pingCommand = "PING", syntaxSearchCommand = "SYNTAX", semanticSearchCommand = "SEMANTIC",
+                     substringSearchCommand = "SUBSTRING";
+    const QByteArray okStatus = "OK", errorStatus = "ERROR";
+}
+
+QByteArray FrameModelProtocol::EncodeRequest(const Request& request) {
+    QByteArray line = QByteArray::number(request.id);
+
+    switch (request.command) {
+    case Command::Ping:
+        line += '\t' + pingCommand;
+        break;
+    case Command::SyntaxSearch:
+        line += '\t' + syntaxSearchCommand;
+        break;
+    case Command::SemanticSearch:
+        line += '\t' + semanticSearchCommand;
+        break;
+    case Command::SubstringSearch:
+        line += '\t' + substringSearchCommand;
+        break;
+    }
+
+    for (auto argument : request.arguments) {
+        line += '\t' + argument.replace('\t', ' ').replace('\n', ' ').toUtf8();
+    }
+
+    return line + '\n';
+}
+
+bool FrameModelProtocol::DecodeRequest(const QByteArray& line, Request& request) {
+    const auto fields = line.split('\t');
+    bool isIdValid = false;
+
+    request.id = fields[0].toULongLong(&isIdValid);
+
+    if (!isIdValid || fields.size() < 2)
+        return false;
+
+    if (fields[1] == pingCommand)
+        request.command = Command::Ping;
+    else if (fields[1] == syntaxSearchCommand)
+        request.command = Command::SyntaxSearch;
+    else if (fields[1] == semanticSearchCommand)
+        request.command = Command::SemanticSearch;
+    else if (fields[1] == substringSearchCommand)
+        request.command = Command::SubstringSearch;
+    else
+        return false;
+
+    request.arguments.clear();
+
+    for (int fieldIndex = 2; fieldIndex < fields.size(); ++fieldIndex) {
+        request.arguments.append(QString::fromUtf8(fields[fieldIndex]));
+    }
+
+    return true;
+}
+
+QByteArray FrameModelProtocol::EncodeResponse(const Response& response) {
+    const auto body = response.text.toUtf8();
+    return QByteArray::number(response.requestId) + '\t' + (response.isOk ? okStatus : errorStatus) + '\t' +
+           QByteArray::number(body.size()) + '\n' + body;
+}
+
+bool FrameModelProtocol::DecodeResponse(QByteArray& buffer, Response& response) {
+    const int headerEnd = buffer.indexOf('\n');
+
+    if (headerEnd < 0)
+        return false;
+
+    const auto header = buffer.left(headerEnd).split('\t');
+    const int bodySize = header.size() == 3 ? header[2].toInt() : 0;
+
+    if (buffer.size() < headerEnd + 1 + bodySize)
+        return false;
+
+    response.requestId = header[0].toULongLong();
+    response.isOk = header.size() == 3 && header[1] == okStatus;
+    response.text = QString::fromUtf8(buffer.constData() + headerEnd + 1, bodySize);
+    buffer.remove(0, headerEnd + 1 + bodySize);
+    return true;
+}
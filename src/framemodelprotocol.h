@@ -0,0 +1,45 @@
+#ifndef FRAMEMODELPROTOCOL_H
+#define FRAMEMODELPROTOCOL_H
+
+#include <QByteArray>
+#include <QStringList>
+
+// Протокол сервера запросов к модели поверх QLocalSocket, все строки в UTF-8.
+// Запрос — одна строка: RequestId \t Команда \t Аргумент \t Аргумент ... \n
+// Ответ — строка заголовка RequestId \t OK|ERROR \t ДлинаТелаВБайтах \n, за которой следует тело.
+// Клиент может отправлять запросы, не дожидаясь ответов на предыдущие (конвейер), а сервер выполняет их
+// параллельно, поэтому ответы приходят в порядке готовности и сопоставляются с запросами по RequestId
+namespace FrameModelProtocol {
+    enum class Command {
+        Ping,
+        SyntaxSearch,
+        SemanticSearch,
+        // Аргументы: подстрока и необязательный флаг caseFoldFlag для поиска без учёта регистра
+        SubstringSearch
+    };
+
+    struct Request {
+        quint64 id = 0;
+        Command command = Command::Ping;
+        QStringList arguments; // Не могут содержать табуляций и переводов строк
+    };
+
+    struct Response {
+        quint64 requestId = 0;
+        bool isOk = false;
+        QString text; // Результат поиска или описание ошибки
+    };
+
+    inline const QString defaultServerName = "framemodel";
+    inline const QString caseFoldFlag = "CASEFOLD";
+
+    QByteArray EncodeRequest(const Request& request);
+    // line — строка запроса без перевода строки. Если команда неизвестна, но RequestId разобран,
+    // он всё равно записывается в request, чтобы на запрос можно было ответить ошибкой
+    bool DecodeRequest(const QByteArray& line, Request& request);
+    QByteArray EncodeResponse(const Response& response);
+    // Извлекает из начала буфера один ответ. false — ответ пришёл ещё не целиком
+    bool DecodeResponse(QByteArray& buffer, Response& response);
+}
+
+#endif // FRAMEMODELPROTOCOL_H
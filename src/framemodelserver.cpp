@@ -0,0 +1,134 @@
+#include "framemodelserver.h"
+#include "profiler.h"
+#include <QLocalSocket>
+
+FrameModelServer::FrameModelServer(const FrameModel& frameModel, QObject* parent) : QObject(parent), _frameModel(frameModel)
+{
+    // Подключаться к серверу может только пользователь, запустивший его
+    _localServer.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&_localServer, &QLocalServer::newConnection, this, &FrameModelServer::OnNewConnection);
+}
+
+FrameModelServer::~FrameModelServer() {
+    _localServer.close();
+    // Ответы ещё выполняющихся запросов отправляются событиями этому объекту и после его удаления отбрасываются
+    _threadPool.waitForDone();
+}
+
+bool FrameModelServer::Listen(const QString& serverName) {
+    // Сокет, оставшийся от аварийно завершившегося сервера, иначе не дал бы занять имя
+    QLocalServer::removeServer(serverName);
+    return _localServer.listen(serverName);
+}
+
+QString FrameModelServer::GetErrorString() const {
+    return _localServer.errorString();
+}
+
+void FrameModelServer::OnNewConnection() {
+    while (auto* socket = _localServer.nextPendingConnection()) {
+        const auto connectionId = _nextConnectionId++;
+        _connections.insert(connectionId, {socket, QByteArray()});
+
+        connect(socket, &QLocalSocket::readyRead, this, [=]() {
+            ReadRequests(connectionId);
+        });
+
+        connect(socket, &QLocalSocket::disconnected, this, [=]() {
+            CloseConnection(connectionId);
+        });
+
+        PROFILE_COUNTER("FrameModelServer: соединений", _connections.size());
+    }
+}
+
+void FrameModelServer::ReadRequests(quint64 connectionId) {
+    const auto connectionIt = _connections.find(connectionId);
+
+    if (connectionIt == _connections.end())
+        return;
+
+    auto& connection = connectionIt.value();
+    connection.buffer += connection.socket->readAll();
+
+    while (connection.inFlightRequestsCount < _maxInFlightRequestsCount) {
+        const int lineEnd = connection.buffer.indexOf('\n');
+
+        if (lineEnd < 0)
+            break;
+
+        FrameModelProtocol::Request request;
+        const bool isRequestValid = FrameModelProtocol::DecodeRequest(connection.buffer.left(lineEnd), request);
+        connection.buffer.remove(0, lineEnd + 1);
+
+        if (!isRequestValid) {
+            connection.socket->write(FrameModelProtocol::EncodeResponse({request.id, false, "Неизвестная команда"}));
+            continue;
+        }
+
+        ++connection.inFlightRequestsCount;
+
+        _threadPool.start(QRunnable::create([=]() {
+            const auto response = FrameModelProtocol::EncodeResponse(Execute(request));
+
+            QMetaObject::invokeMethod(this, [=]() {
+                SendResponse(connectionId, response);
+            }, Qt::QueuedConnection);
+        }));
+    }
+
+    // Строка запроса без перевода строки такой длины — не запрос по протоколу
+    if (connection.buffer.size() > _maxRequestBytes)
+        connection.socket->abort();
+}
+
+void FrameModelServer::SendResponse(quint64 connectionId, const QByteArray& response) {
+    const auto connectionIt = _connections.find(connectionId);
+
+    // Клиент отключился, не дождавшись ответа
+    if (connectionIt == _connections.end())
+        return;
+
+    connectionIt->socket->write(response);
+    --connectionIt->inFlightRequestsCount;
+
+    // В буфере могли остаться запросы, разбор которых был приостановлен
+    if (connectionIt->buffer.contains('\n'))
+        ReadRequests(connectionId);
+}
+
+void FrameModelServer::CloseConnection(quint64 connectionId) {
+    const auto connection = _connections.take(connectionId);
+
+    if (connection.socket)
+        connection.socket->deleteLater();
+
+    PROFILE_COUNTER("FrameModelServer: соединений", _connections.size());
+}
+
+FrameModelProtocol::Response FrameModelServer::Execute(const FrameModelProtocol::Request& request) const {
+    PROFILE_SCOPE("FrameModelServer::Execute");
+
+    switch (request.command) {
+    case FrameModelProtocol::Command::Ping:
+        return {request.id, true, QString()};
+    case FrameModelProtocol::Command::SyntaxSearch:
+        if (request.arguments.isEmpty())
+            return {request.id, false, "Не заданы имена слотов"};
+
+        return {request.id, true, _frameModel.SyntaxSearch(request.arguments)};
+    case FrameModelProtocol::Command::SemanticSearch:
+        if (request.arguments.isEmpty())
+            return {request.id, false, "Не заданы значения слотов"};
+
+        return {request.id, true, _frameModel.SemanticSearch(request.arguments)};
+    case FrameModelProtocol::Command::SubstringSearch:
+        if (request.arguments.isEmpty() || request.arguments[0].isEmpty())
+            return {request.id, false, "Не задана подстрока"};
+
+        return {request.id, true, _frameModel.SubstringSearch(request.arguments[0], request.arguments.value(1) == FrameModelProtocol::caseFoldFlag ?
+                                                              Qt::CaseInsensitive : Qt::CaseSensitive)};
+    }
+
+    return {request.id, false, "Неизвестная команда"};
+}
@@ -0,0 +1,49 @@
+#ifndef FRAMEMODELSERVER_H
+#define FRAMEMODELSERVER_H
+
+#include "framemodel.h"
+#include "framemodelprotocol.h"
+#include <QLocalServer>
+#include <QThreadPool>
+
+class QLocalSocket;
+
+// Сервер синтаксических и семантических запросов к модели, загруженной в память один раз, по протоколу
+// FrameModelProtocol. Сокеты обслуживаются в потоке сервера, а запросы выполняются параллельно в пуле
+// потоков. Модель при этом только читается, поэтому она должна быть загружена целиком (без FrameSource)
+// и не меняться, пока сервер работает
+class FrameModelServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FrameModelServer(const FrameModel& frameModel, QObject* parent = nullptr);
+    ~FrameModelServer();
+    bool Listen(const QString& serverName);
+    QString GetErrorString() const;
+
+private:
+    struct Connection {
+        QLocalSocket* socket = nullptr;
+        QByteArray buffer; // Ещё не разобранные байты запросов
+        int inFlightRequestsCount = 0;
+    };
+
+    const FrameModel& _frameModel;
+    QLocalServer _localServer;
+    QThreadPool _threadPool;
+    QHash<quint64, Connection> _connections; // [ConnectionId, Connection]
+    quint64 _nextConnectionId = 0;
+
+    // Пока у соединения столько запросов в работе, новые из его буфера не разбираются:
+    // клиент, отправляющий запросы быстрее, чем они выполняются, не займёт всю очередь пула
+    inline static constexpr int _maxInFlightRequestsCount = 64;
+    inline static constexpr int _maxRequestBytes = 1 << 20;
+
+    void OnNewConnection();
+    void ReadRequests(quint64 connectionId);
+    void SendResponse(quint64 connectionId, const QByteArray& response);
+    void CloseConnection(quint64 connectionId);
+    FrameModelProtocol::Response Execute(const FrameModelProtocol::Request& request) const;
+};
+
+#endif // FRAMEMODELSERVER_H
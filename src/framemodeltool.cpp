@@ -0,0 +1,342 @@
+#include "framemodeltool.h"
+#include "framemodelclient.h"
+#include "framemodeldiff.h"
+#include "framemodelfile.h"
+#include "framemodelimporter.h"
+#include "framemodelserver.h"
+#include "framemodelvalidator.h"
+#include "slotstringpool.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+    bool LoadModel(const QString& filePath, FrameModel& frameModel, QTextStream& err) {
+        if (FrameModelFile::Load(filePath, frameModel))
+            return true;
+
+        err << QString("Не удалось открыть файл модели %1\n").arg(filePath);
+        return false;
+    }
+
+    int Diff(const QString& oldFilePath, const QString& newFilePath, QTextStream& out, QTextStream& err) {
+        FrameModel oldFrameModel, newFrameModel;
+
+        if (!LoadModel(oldFilePath, oldFrameModel, err) || !LoadModel(newFilePath, newFrameModel, err))
+            return 2;
+
+        const auto frameModelDiff = FrameModelDiff::Compare(oldFrameModel, newFrameModel);
+        out << frameModelDiff.ToText();
+        return frameModelDiff.IsEmpty() ? 0 : 1;
+    }
+
+    int Merge(const QString& baseFilePath, const QString& ourFilePath, const QString& theirFilePath, const QString& outFilePath,
+              QTextStream& err) {
+        FrameModel baseFrameModel, ourFrameModel, theirFrameModel;
+
+        if (!LoadModel(baseFilePath, baseFrameModel, err) || !LoadModel(ourFilePath, ourFrameModel, err) ||
+            !LoadModel(theirFilePath, theirFrameModel, err))
+            return 2;
+
+        const auto conflicts = FrameModelDiff::Merge(baseFrameModel, ourFrameModel, theirFrameModel);
+
+        if (!FrameModelFile::Save(outFilePath, ourFrameModel)) {
+            err << QString("Не удалось записать файл модели %1\n").arg(outFilePath);
+            return 2;
+        }
+
+        for (const auto& conflict : conflicts) {
+            err << QString("Конфликт: %1\n").arg(conflict);
+        }
+
+        return conflicts.isEmpty() ? 0 : 1;
+    }
+
+    int Validate(const QString& filePath, const QString& repairedFilePath, QTextStream& out, QTextStream& err) {
+        QElapsedTimer validationTimer;
+        validationTimer.start();
+
+        const auto validation = FrameModelValidator::Validate(filePath, repairedFilePath);
+
+        if (!validation.isFileOpened) {
+            err << QString("Не удалось открыть файл модели %1\n").arg(filePath);
+            return 2;
+        }
+
+        out << validation.ToText();
+        out << QString("Проверка заняла %1 мс\n").arg(validationTimer.elapsed());
+
+        if (!repairedFilePath.isEmpty() && !validation.isRepaired) {
+            err << QString("Не удалось записать файл модели %1\n").arg(repairedFilePath);
+            return 2;
+        }
+
+        return validation.GetErrorsCount() > 0 ? 1 : 0;
+    }
+
+    // Импорт таблицы в модель с замером времени и запись результата в outFilePath
+    int Import(const QString& filePath, const QString& tableFilePath, const QString& outFilePath, QTextStream& out, QTextStream& err) {
+        FrameModel frameModel;
+
+        if (!LoadModel(filePath, frameModel, err))
+            return 2;
+
+        QElapsedTimer importTimer;
+        importTimer.start();
+
+        const auto import = FrameModelImporter::Import(tableFilePath, frameModel);
+
+        if (!import.isFileOpened) {
+            err << QString("Не удалось открыть таблицу %1\n").arg(tableFilePath);
+            return 2;
+        }
+
+        out << import.ToText();
+        out << QString("Импорт занял %1 мс\n").arg(importTimer.elapsed());
+
+        if (!import.isCommitted)
+            return 2;
+
+        if (!FrameModelFile::Save(outFilePath, frameModel)) {
+            err << QString("Не удалось записать файл модели %1\n").arg(outFilePath);
+            return 2;
+        }
+
+        return import.GetErrorsCount() > 0 ? 1 : 0;
+    }
+
+    // Поиск подстроки в слотах модели с замером скорости просмотра пула строк
+    int Find(const QString& filePath, const QString& substring, Qt::CaseSensitivity caseSensitivity, QTextStream& out, QTextStream& err) {
+        FrameModel frameModel;
+
+        if (!LoadModel(filePath, frameModel, err))
+            return 2;
+
+        SlotStringPool slotStringPool;
+        int foundSlotsCount = 0;
+
+        frameModel.GetFramePool().ForEach([&](FrameHandle, const FramePool::Entry& entry) {
+            slotStringPool.Append(entry.frame);
+        });
+
+        QElapsedTimer searchTimer;
+        searchTimer.start();
+        slotStringPool.Search(substring, caseSensitivity, [&](const SlotStringPool::SlotLocation&) {
+            ++foundSlotsCount;
+        });
+
+        const auto elapsedNs = std::max(searchTimer.nsecsElapsed(), qint64(1));
+
+        out << frameModel.SubstringSearch(substring, caseSensitivity);
+        out << QString("Найдено слотов: %1. Просмотрено %2 МБ за %3 мс (%4 ГБ/с), ядро %5\n").arg(foundSlotsCount).
+               arg(QString::number(slotStringPool.GetTextBytes() / 1e6, 'f', 1), QString::number(elapsedNs / 1e6, 'f', 3),
+                   QString::number(slotStringPool.GetTextBytes() / double(elapsedNs), 'f', 2), SlotStringPool::GetKernelName());
+        return foundSlotsCount > 0 ? 0 : 1;
+    }
+
+    bool ParseCommand(const QString& commandName, FrameModelProtocol::Command& command) {
+        if (commandName == "ping")
+            command = FrameModelProtocol::Command::Ping;
+        else if (commandName == "syntax")
+            command = FrameModelProtocol::Command::SyntaxSearch;
+        else if (commandName == "semantic")
+            command = FrameModelProtocol::Command::SemanticSearch;
+        else if (commandName == "substring")
+            command = FrameModelProtocol::Command::SubstringSearch;
+        else
+            return false;
+
+        return true;
+    }
+
+    int Serve(const QString& filePath, const QString& serverName, QTextStream& out, QTextStream& err) {
+        FrameModel frameModel;
+
+        if (!LoadModel(filePath, frameModel, err))
+            return 2;
+
+        FrameModelServer frameModelServer(frameModel);
+
+        if (!frameModelServer.Listen(serverName)) {
+            err << QString("Не удалось запустить сервер %1: %2\n").arg(serverName, frameModelServer.GetErrorString());
+            return 2;
+        }
+
+        out << QString("Модель %1 (%2 фреймов) доступна по имени %3\n").arg(filePath).arg(frameModel.Size()).arg(serverName);
+        out.flush();
+        return QCoreApplication::exec();
+    }
+
+    int Query(const QString& serverName, FrameModelProtocol::Command command, const QStringList& arguments, QTextStream& out, QTextStream& err) {
+        FrameModelClient frameModelClient;
+
+        if (!frameModelClient.Connect(serverName)) {
+            err << QString("Не удалось подключиться к серверу %1: %2\n").arg(serverName, frameModelClient.GetErrorString());
+            return 2;
+        }
+
+        QString result;
+        const bool isOk = frameModelClient.Query(command, arguments, result);
+        (isOk ? out : err) << result << '\n';
+        return isOk ? 0 : 1;
+    }
+
+    // Генератор нагрузки: clientsCount потоков, у каждого своё соединение и до pipelineDepth запросов в работе
+    int Benchmark(const QString& serverName, int clientsCount, int requestsCount, int pipelineDepth,
+                  FrameModelProtocol::Command command, const QStringList& arguments, QTextStream& out, QTextStream& err) {
+        clientsCount = std::max(clientsCount, 1);
+        pipelineDepth = std::max(pipelineDepth, 1);
+
+        const int clientRequestsCount = std::max(requestsCount / clientsCount, 1);
+        QVector<QVector<qint64>> clientLatenciesNs(clientsCount);
+        std::atomic_int failedClientsCount {0};
+        QVector<QThread*> clientThreads;
+
+        for (int clientIndex = 0; clientIndex < clientsCount; ++clientIndex) {
+            clientThreads.append(QThread::create([&, clientIndex]() {
+                FrameModelClient frameModelClient;
+
+                if (!frameModelClient.Connect(serverName)) {
+                    ++failedClientsCount;
+                    return;
+                }
+
+                auto& latenciesNs = clientLatenciesNs[clientIndex];
+                QHash<quint64, qint64> sentNs; // [RequestId, момент отправки]
+                QElapsedTimer clientTimer;
+                int sentRequestsCount = 0;
+
+                latenciesNs.reserve(clientRequestsCount);
+                clientTimer.start();
+
+                while (latenciesNs.size() < clientRequestsCount) {
+                    while (sentRequestsCount < clientRequestsCount && sentRequestsCount - latenciesNs.size() < pipelineDepth) {
+                        sentNs.insert(frameModelClient.Send(command, arguments), clientTimer.nsecsElapsed());
+                        ++sentRequestsCount;
+                    }
+
+                    FrameModelProtocol::Response response;
+
+                    if (!frameModelClient.Receive(response) || !response.isOk) {
+                        ++failedClientsCount;
+                        return;
+                    }
+
+                    latenciesNs.append(clientTimer.nsecsElapsed() - sentNs.take(response.requestId));
+                }
+            }));
+        }
+
+        QElapsedTimer benchmarkTimer;
+        benchmarkTimer.start();
+
+        for (auto* clientThread : qAsConst(clientThreads)) {
+            clientThread->start();
+        }
+
+        for (auto* clientThread : qAsConst(clientThreads)) {
+            clientThread->wait();
+            delete clientThread;
+        }
+
+        const auto elapsedNs = benchmarkTimer.nsecsElapsed();
+        QVector<qint64> latenciesNs;
+
+        for (const auto& clientLatencies : qAsConst(clientLatenciesNs)) {
+            latenciesNs += clientLatencies;
+        }
+
+        if (latenciesNs.isEmpty()) {
+            err << QString("Ни один запрос к серверу %1 не выполнен\n").arg(serverName);
+            return 2;
+        }
+
+        std::sort(latenciesNs.begin(), latenciesNs.end());
+
+        const auto getPercentileMs = [&](double percentile) {
+            const int latencyIndex = std::min(static_cast<int>(percentile * latenciesNs.size()), latenciesNs.size() - 1);
+            return QString::number(latenciesNs[latencyIndex] / 1e6, 'f', 3);
+        };
+
+        out << QString("Клиентов: %1, запросов: %2, глубина конвейера: %3\n").arg(clientsCount).arg(latenciesNs.size()).arg(pipelineDepth);
+        out << QString("Запросов в секунду: %1\n").arg(QString::number(latenciesNs.size() * 1e9 / elapsedNs, 'f', 0));
+        out << QString("Задержка, мс: p50 %1, p90 %2, p99 %3, p99.9 %4, максимум %5\n").
+               arg(getPercentileMs(0.5), getPercentileMs(0.9), getPercentileMs(0.99), getPercentileMs(0.999), getPercentileMs(1.0));
+
+        if (failedClientsCount > 0) {
+            err << QString("Клиентов, прерванных ошибкой: %1\n").arg(failedClientsCount.load());
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+bool FrameModelTool::IsToolCommand(int argc, char* argv[]) {
+    if (argc < 2)
+        return false;
+
+    for (const auto* toolCommand : {"--diff", "--merge", "--validate", "--repair", "--import", "--find", "--serve", "--query", "--bench"}) {
+        if (std::strcmp(argv[1], toolCommand) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int FrameModelTool::Run(const QStringList& arguments) {
+    QTextStream out(stdout), err(stderr);
+
+    if (arguments.size() == 4 && arguments[1] == "--diff")
+        return Diff(arguments[2], arguments[3], out, err);
+
+    if (arguments.size() == 6 && arguments[1] == "--merge")
+        return Merge(arguments[2], arguments[3], arguments[4], arguments[5], err);
+
+    if (arguments.size() == 3 && arguments[1] == "--validate")
+        return Validate(arguments[2], QString(), out, err);
+
+    if (arguments.size() == 4 && arguments[1] == "--repair")
+        return Validate(arguments[2], arguments[3], out, err);
+
+    if (arguments.size() == 5 && arguments[1] == "--import")
+        return Import(arguments[2], arguments[3], arguments[4], out, err);
+
+    if (arguments.size() == 4 && arguments[1] == "--find")
+        return Find(arguments[2], arguments[3], Qt::CaseSensitive, out, err);
+
+    if (arguments.size() == 5 && arguments[1] == "--find" && arguments[4] == "casefold")
+        return Find(arguments[2], arguments[3], Qt::CaseInsensitive, out, err);
+
+    if ((arguments.size() == 3 || arguments.size() == 4) && arguments[1] == "--serve")
+        return Serve(arguments[2], arguments.value(3, FrameModelProtocol::defaultServerName), out, err);
+
+    FrameModelProtocol::Command command;
+
+    if (arguments.size() >= 4 && arguments[1] == "--query" && ParseCommand(arguments[3], command))
+        return Query(arguments[2], command, arguments.mid(4), out, err);
+
+    if (arguments.size() == 6 && arguments[1] == "--bench")
+        return Benchmark(arguments[2], arguments[3].toInt(), arguments[4].toInt(), arguments[5].toInt(),
+                         FrameModelProtocol::Command::Ping, QStringList(), out, err);
+
+    if (arguments.size() >= 7 && arguments[1] == "--bench" && ParseCommand(arguments[6], command))
+        return Benchmark(arguments[2], arguments[3].toInt(), arguments[4].toInt(), arguments[5].toInt(),
+                         command, arguments.mid(7), out, err);
+
+    err << "Использование:\n"
+           "  --diff old.fm new.fm\n"
+           "  --merge base.fm ours.fm theirs.fm out.fm\n"
+           "  --validate model.fm\n"
+           "  --repair model.fm out.fm\n"
+           "  --import model.fm table.csv out.fm\n"
+           "  --find model.fm подстрока [casefold]\n"
+           "  --serve model.fm [имя_сервера]\n"
+           "  --query имя_сервера ping|syntax|semantic|substring [аргумент...]\n"
+           "  --bench имя_сервера клиентов запросов глубина_конвейера [ping|syntax|semantic|substring аргумент...]\n";
+    return 2;
+}
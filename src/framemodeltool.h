@@ -0,0 +1,24 @@
+#ifndef FRAMEMODELTOOL_H
+#define FRAMEMODELTOOL_H
+
+#include <QStringList>
+
+// Команды для работы с файлами моделей из командной строки, без открытия окна:
+//   --diff old.fm new.fm                      — различия двух версий модели (код возврата 1, если они есть)
+//   --merge base.fm ours.fm theirs.fm out.fm  — трёхстороннее слияние (код возврата 1 при конфликтах)
+//   --validate model.fm                       — проверка файла модели (код возврата 1, если есть ошибки)
+//   --repair model.fm out.fm                  — проверка и запись исправленной модели в out.fm
+//   --import model.fm table.csv out.fm        — импорт таблицы CSV или TSV (FrameModelImporter) и запись
+//                                               модели в out.fm (код возврата 1, если были пропущены ошибки)
+//   --find model.fm подстрока [casefold]      — поиск подстроки в слотах (casefold — без учёта регистра)
+//                                               и скорость просмотра пула строк
+//   --serve model.fm [имя]                    — сервер запросов к модели (FrameModelServer)
+//   --query имя команда [аргумент...]         — один запрос к серверу
+//   --bench имя клиентов запросов глубина [команда аргумент...] — нагрузка на сервер: запросы в секунду
+//                                               и перцентили задержки
+namespace FrameModelTool {
+    bool IsToolCommand(int argc, char* argv[]);
+    int Run(const QStringList& arguments);
+}
+
+#endif // FRAMEMODELTOOL_H
@@ -0,0 +1,612 @@
+#include "framemodelvalidator.h"
+#include "profiler.h"
+#include <QFile>
+#include <QHash>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace {
+    using Finding = FrameModelValidation::Finding;
+    using Severity = FrameModelValidation::Severity;
+
+    // Поля строк — невладеющие представления байтов UTF-8 отображённого в память файла. QLatin1String
+    // хешируется и сравнивается побайтно, поэтому разбор и поиск имён обходятся без копирования строк
+    using ByteView = QLatin1String;
+
+    enum class LineKind : quint8 { Empty, Frame, Slot, Malformed };
+
+    struct ParsedLine {
+        ByteView text; // Без перевода строки и лишних полей
+        ByteView name, slotName; // name — имя фрейма в записи о фрейме и имя целевого фрейма в записи о слоте
+        uint nameHash = 0, slotNameHash = 0; // slotNameHash — только у слотов-фреймов
+        int lineNumber = 0, x = 0, y = 0;
+        LineKind kind = LineKind::Empty;
+        bool isFrameReference = false, isRemoved = false, isRewritten = false;
+    };
+
+    // Строки, части и разделы разбираются и помечаются разными потоками одновременно, поэтому хранятся
+    // в std::vector: неконстантный доступ к элементам QVector проверяет, не нужно ли отделить копию
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        std::vector<ParsedLine> lines;
+        QVector<Finding> findings;
+    };
+
+    struct ReferenceEdge {
+        int sourceFrameIndex, targetFrameIndex;
+        const ParsedLine* line;
+    };
+
+    // Раздел фреймов, хеши имён которых дают один остаток от деления на число разделов
+    struct Partition {
+        QHash<ByteView, int> frameIndices; // [FrameName, индекс фрейма в разделе]
+        QVector<ParsedLine*> frameLines; // Действующее (последнее) объявление каждого фрейма раздела
+        QVector<ReferenceEdge> referenceEdges;
+        QVector<Finding> findings;
+        int slotsCount = 0;
+    };
+
+    const ByteView frameKeyword("Фрейм"), slotKeyword("Слот"), frameReferenceKeyword("Фрейм-ссылка");
+    constexpr int frameFieldsCount = 4, slotFieldsCount = 6;
+    constexpr int maxFrameCoord = 9999; // Как на холсте FrameModelWidget
+    constexpr int maxCycleNamesShown = 5;
+    constexpr int writeBufferBytes = 1 << 20;
+
+    QString ToName(ByteView field) {
+        return QString::fromUtf8(field.data(), field.size()).replace('_', ' ');
+    }
+
+    void AddFinding(QVector<Finding>& findings, const ParsedLine& line, Severity severity, const QString& message) {
+        findings.append({line.lineNumber, severity, message});
+    }
+
+    void ParallelFor(int tasksCount, const std::function<void(int)>& task) {
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount(tasksCount);
+
+        for (int taskIndex = 0; taskIndex < tasksCount; ++taskIndex) {
+            threadPool.start(QRunnable::create([&task, taskIndex]() { task(taskIndex); }));
+        }
+
+        threadPool.waitForDone();
+    }
+
+    // Делит строку по пробелам, как QString::split(' '): пустые поля между соседними пробелами сохраняются.
+    // Возвращает число всех полей, в fields записываются не более fieldsCapacity первых
+    int SplitLine(ByteView line, ByteView* fields, int fieldsCapacity) {
+        const char* fieldBegin = line.data();
+        const char* const lineEnd = line.data() + line.size();
+        int fieldsCount = 0;
+
+        for (const char* it = fieldBegin;; ++it) {
+            if (it != lineEnd && *it != ' ')
+                continue;
+
+            if (fieldsCount < fieldsCapacity)
+                fields[fieldsCount] = ByteView(fieldBegin, static_cast<int>(it - fieldBegin));
+
+            ++fieldsCount;
+
+            if (it == lineEnd)
+                return fieldsCount;
+
+            fieldBegin = it + 1;
+        }
+    }
+
+    // Те же правила, что у QString::toInt при загрузке. Обычная запись — цифры с необязательным знаком —
+    // разбирается без перевода в QString, а остальное (пробелы по краям, переполнение и т. п.) — самим toInt
+    bool ParseCoordinate(ByteView field, int& coordinate) {
+        const char* it = field.data();
+        const char* const fieldEnd = field.data() + field.size();
+        const bool isNegative = it != fieldEnd && *it == '-';
+        int value = 0;
+
+        if (it != fieldEnd && (*it == '-' || *it == '+'))
+            ++it;
+
+        if (it != fieldEnd && fieldEnd - it <= 9 && std::all_of(it, fieldEnd, [](char c) { return c >= '0' && c <= '9'; })) {
+            for (; it != fieldEnd; ++it) {
+                value = value * 10 + (*it - '0');
+            }
+
+            coordinate = isNegative ? -value : value;
+            return true;
+        }
+
+        bool isParsed = false;
+        coordinate = QString::fromUtf8(field.data(), field.size()).toInt(&isParsed);
+        return isParsed;
+    }
+
+    void ParseLine(ParsedLine& line, QVector<Finding>& findings) {
+        ByteView fields[slotFieldsCount];
+        const int fieldsCount = SplitLine(line.text, fields, slotFieldsCount);
+
+        if (line.text.isEmpty())
+            return;
+
+        const auto markMalformed = [&](const QString& message) {
+            line.kind = LineKind::Malformed;
+            line.isRemoved = true;
+            AddFinding(findings, line, Severity::Error, message);
+        };
+
+        const auto truncateExtraFields = [&](int expectedFieldsCount, const QString& recordName) {
+            if (fieldsCount <= expectedFieldsCount)
+                return;
+
+            const auto& lastField = fields[expectedFieldsCount - 1];
+            line.text = ByteView(line.text.data(), static_cast<int>(lastField.data() + lastField.size() - line.text.data()));
+            line.isRewritten = true;
+            AddFinding(findings, line, Severity::Error,
+                       QString("Лишние поля в записи о %1: ожидалось %2, получено %3").arg(recordName).arg(expectedFieldsCount).arg(fieldsCount));
+        };
+
+        if (fields[0] == frameKeyword) {
+            if (fieldsCount < frameFieldsCount)
+                return markMalformed(QString("Не хватает полей в записи о фрейме: ожидалось %1, получено %2").arg(frameFieldsCount).arg(fieldsCount));
+
+            if (fields[1].isEmpty())
+                return markMalformed("Пустое имя фрейма");
+
+            line.kind = LineKind::Frame;
+            line.name = fields[1];
+            line.nameHash = qHash(line.name);
+            truncateExtraFields(frameFieldsCount, "фрейме");
+
+            const bool isXParsed = ParseCoordinate(fields[2], line.x);
+            const bool isYParsed = ParseCoordinate(fields[3], line.y);
+
+            if (!isXParsed || !isYParsed) {
+                line.isRewritten = true;
+                AddFinding(findings, line, Severity::Error, QString("Координаты фрейма \"%1\" не являются целыми числами").arg(ToName(line.name)));
+            }
+
+            if (line.x < 0 || line.x > maxFrameCoord || line.y < 0 || line.y > maxFrameCoord) {
+                AddFinding(findings, line, Severity::Error, QString("Координаты фрейма \"%1\" (%2, %3) вне холста 0..%4").
+                           arg(ToName(line.name)).arg(line.x).arg(line.y).arg(maxFrameCoord));
+                line.x = qBound(0, line.x, maxFrameCoord);
+                line.y = qBound(0, line.y, maxFrameCoord);
+                line.isRewritten = true;
+            }
+        }
+        else if (fields[0] == slotKeyword) {
+            if (fieldsCount < slotFieldsCount)
+                return markMalformed(QString("Не хватает полей в записи о слоте: ожидалось %1, получено %2").arg(slotFieldsCount).arg(fieldsCount));
+
+            if (fields[1].isEmpty() || fields[5].isEmpty())
+                return markMalformed("Пустое имя слота или целевого фрейма");
+
+            line.kind = LineKind::Slot;
+            line.name = fields[5];
+            line.nameHash = qHash(line.name);
+            line.slotName = fields[1];
+            line.isFrameReference = fields[3] == frameReferenceKeyword;
+
+            if (line.isFrameReference)
+                line.slotNameHash = qHash(line.slotName);
+
+            truncateExtraFields(slotFieldsCount, "слоте");
+        }
+        else {
+            markMalformed("Строка не является записью о фрейме или слоте");
+        }
+    }
+
+    void ParseChunk(Chunk& chunk) {
+        chunk.lines.reserve(static_cast<size_t>(chunk.end - chunk.begin) / 32);
+
+        for (const char* lineBegin = chunk.begin; lineBegin < chunk.end;) {
+            const auto* newline = static_cast<const char*>(std::memchr(lineBegin, '\n', static_cast<size_t>(chunk.end - lineBegin)));
+            const char* textEnd = newline ? newline : chunk.end;
+
+            if (textEnd > lineBegin && textEnd[-1] == '\r')
+                --textEnd;
+
+            ParsedLine line;
+            line.text = ByteView(lineBegin, static_cast<int>(textEnd - lineBegin));
+            line.lineNumber = static_cast<int>(chunk.lines.size()) + 1; // Внутри части, сдвигается после разбора всех частей
+            ParseLine(line, chunk.findings);
+            chunk.lines.push_back(line);
+
+            lineBegin = newline ? newline + 1 : chunk.end;
+        }
+    }
+
+    // Компоненты сильной связности графа ссылок (алгоритм Тарьяна без рекурсии); рёбра — в виде списков смежности
+    // edgeOffsets/edgeTargets. Возвращает номер компоненты каждого фрейма
+    QVector<int> FindStronglyConnectedComponents(const QVector<int>& edgeOffsets, const QVector<int>& edgeTargets) {
+        const int framesCount = edgeOffsets.size() - 1;
+        QVector<int> indices(framesCount, -1), lowLinks(framesCount), components(framesCount, -1);
+        QVector<bool> isOnStack(framesCount, false);
+        QVector<int> stack;
+        QVector<QPair<int, int>> callStack; // [фрейм, позиция следующего ребра]
+        int nextIndex = 0, componentsCount = 0;
+
+        const auto visit = [&](int frameIndex) {
+            indices[frameIndex] = lowLinks[frameIndex] = nextIndex++;
+            stack.append(frameIndex);
+            isOnStack[frameIndex] = true;
+            callStack.append({frameIndex, edgeOffsets[frameIndex]});
+        };
+
+        for (int rootIndex = 0; rootIndex < framesCount; ++rootIndex) {
+            if (indices[rootIndex] >= 0)
+                continue;
+
+            visit(rootIndex);
+
+            while (!callStack.isEmpty()) {
+                const int frameIndex = callStack.last().first;
+                int& edgePosition = callStack.last().second;
+
+                if (edgePosition < edgeOffsets[frameIndex + 1]) {
+                    const int targetIndex = edgeTargets[edgePosition++];
+
+                    if (indices[targetIndex] < 0)
+                        visit(targetIndex);
+                    else if (isOnStack[targetIndex])
+                        lowLinks[frameIndex] = std::min(lowLinks[frameIndex], indices[targetIndex]);
+
+                    continue;
+                }
+
+                callStack.removeLast();
+
+                if (!callStack.isEmpty()) {
+                    const int parentIndex = callStack.last().first;
+                    lowLinks[parentIndex] = std::min(lowLinks[parentIndex], lowLinks[frameIndex]);
+                }
+
+                if (lowLinks[frameIndex] != indices[frameIndex])
+                    continue;
+
+                int memberIndex;
+
+                do {
+                    memberIndex = stack.takeLast();
+                    isOnStack[memberIndex] = false;
+                    components[memberIndex] = componentsCount;
+                } while (memberIndex != frameIndex);
+
+                ++componentsCount;
+            }
+        }
+
+        return components;
+    }
+
+    // Предупреждения о циклах ссылок: по одному на компоненту сильной связности из нескольких фреймов,
+    // в строке первого по файлу слота-фрейма цикла
+    void FindReferenceCycles(const std::vector<Partition>& partitions, const QVector<int>& frameIndexOffsets, QVector<Finding>& findings) {
+        const int framesCount = frameIndexOffsets.last();
+        QVector<const ParsedLine*> frameLines;
+        QVector<int> edgeOffsets(framesCount + 1, 0);
+
+        frameLines.reserve(framesCount);
+
+        for (const auto& partition : partitions) {
+            for (const auto* frameLine : partition.frameLines) {
+                frameLines.append(frameLine);
+            }
+
+            for (const auto& referenceEdge : partition.referenceEdges) {
+                ++edgeOffsets[referenceEdge.sourceFrameIndex + 1];
+            }
+        }
+
+        std::partial_sum(edgeOffsets.begin(), edgeOffsets.end(), edgeOffsets.begin());
+
+        QVector<int> edgeTargets(edgeOffsets.last()), edgeCursors(edgeOffsets.begin(), edgeOffsets.end() - 1);
+
+        for (const auto& partition : partitions) {
+            for (const auto& referenceEdge : partition.referenceEdges) {
+                edgeTargets[edgeCursors[referenceEdge.sourceFrameIndex]++] = referenceEdge.targetFrameIndex;
+            }
+        }
+
+        const auto components = FindStronglyConnectedComponents(edgeOffsets, edgeTargets);
+        QHash<int, const ParsedLine*> cycleLines; // [компонента, первая строка цикла]
+
+        for (const auto& partition : partitions) {
+            for (const auto& referenceEdge : partition.referenceEdges) {
+                const int component = components[referenceEdge.sourceFrameIndex];
+
+                if (component != components[referenceEdge.targetFrameIndex])
+                    continue;
+
+                auto& cycleLine = cycleLines[component];
+
+                if (!cycleLine || referenceEdge.line->lineNumber < cycleLine->lineNumber)
+                    cycleLine = referenceEdge.line;
+            }
+        }
+
+        QHash<int, QStringList> cycleFrameNames;
+        QHash<int, int> cycleSizes;
+
+        for (int frameIndex = 0; frameIndex < framesCount && !cycleLines.isEmpty(); ++frameIndex) {
+            const int component = components[frameIndex];
+
+            if (!cycleLines.contains(component))
+                continue;
+
+            if (++cycleSizes[component] <= maxCycleNamesShown)
+                cycleFrameNames[component].append('"' + ToName(frameLines[frameIndex]->name) + '"');
+        }
+
+        for (auto cycleLineIt = cycleLines.cbegin(); cycleLineIt != cycleLines.cend(); ++cycleLineIt) {
+            const int cycleSize = cycleSizes.value(cycleLineIt.key());
+            auto cycleText = cycleFrameNames.value(cycleLineIt.key()).join(", ");
+
+            if (cycleSize > maxCycleNamesShown)
+                cycleText += QString(" и ещё %1").arg(cycleSize - maxCycleNamesShown);
+
+            AddFinding(findings, *cycleLineIt.value(), Severity::Warning, QString("Фреймы %1 ссылаются друг на друга по кругу").arg(cycleText));
+        }
+    }
+
+    bool WriteRepaired(const QString& filePath, const std::vector<Chunk>& chunks) {
+        QSaveFile file(filePath);
+
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        QByteArray buffer;
+        buffer.reserve(writeBufferBytes + 1024);
+
+        const auto append = [&](ByteView field) {
+            buffer.append(field.data(), field.size());
+        };
+
+        for (const auto& chunk : chunks) {
+            for (const auto& line : chunk.lines) {
+                if (line.isRemoved || line.kind == LineKind::Empty)
+                    continue;
+
+                if (line.kind == LineKind::Frame && line.isRewritten) {
+                    append(frameKeyword);
+                    buffer += ' ';
+                    append(line.name);
+                    buffer += ' ' + QByteArray::number(line.x) + ' ' + QByteArray::number(line.y);
+                }
+                else {
+                    append(line.text);
+                }
+
+                buffer += '\n';
+
+                if (buffer.size() >= writeBufferBytes) {
+                    if (file.write(buffer) != buffer.size())
+                        return false;
+
+                    buffer.resize(0);
+                }
+            }
+        }
+
+        return file.write(buffer) == buffer.size() && file.commit();
+    }
+}
+
+int FrameModelValidation::GetErrorsCount() const {
+    return static_cast<int>(std::count_if(findings.cbegin(), findings.cend(), [](const Finding& finding) {
+        return finding.severity == Severity::Error;
+    }));
+}
+
+QString FrameModelValidation::ToText() const {
+    QString text;
+
+    for (const auto& finding : findings) {
+        text += QString("Строка %1: %2: %3\n").arg(finding.lineNumber).
+                arg(QString(finding.severity == Severity::Error ? "ошибка" : "предупреждение"), finding.message);
+    }
+
+    const int errorsCount = GetErrorsCount();
+
+    text += QString("Строк: %1, фреймов: %2, слотов: %3, ошибок: %4, предупреждений: %5\n").
+            arg(linesCount).arg(framesCount).arg(slotsCount).arg(errorsCount).arg(findings.size() - errorsCount);
+
+    if (isRepaired)
+        text += QString("Исправлено: удалено строк %1, изменено строк %2\n").arg(removedLinesCount).arg(rewrittenLinesCount);
+
+    return text;
+}
+
+FrameModelValidation FrameModelValidator::Validate(const QString& filePath, const QString& repairedFilePath) {
+    PROFILE_SCOPE("FrameModelValidator::Validate");
+
+    FrameModelValidation validation;
+    QFile file(filePath);
+
+    if (!file.open(QFile::ReadOnly))
+        return validation;
+
+    validation.isFileOpened = true;
+
+    const qint64 fileSize = file.size();
+    QByteArray fileData;
+    const char* data = fileSize > 0 ? reinterpret_cast<const char*>(file.map(0, fileSize)) : nullptr;
+
+    if (!data) {
+        fileData = file.readAll();
+        data = fileData.constData();
+    }
+
+    const char* const dataEnd = data + fileSize;
+    const int tasksCount = std::max(QThread::idealThreadCount(), 1);
+    std::vector<Chunk> chunks(tasksCount);
+    const char* chunkBegin = data;
+
+    // Границы частей сдвигаются на начало следующей строки
+    for (int chunkIndex = 0; chunkIndex < tasksCount; ++chunkIndex) {
+        const char* chunkEnd = std::max(chunkBegin, data + fileSize * (chunkIndex + 1) / tasksCount);
+
+        if (chunkEnd < dataEnd) {
+            const auto* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', static_cast<size_t>(dataEnd - chunkEnd)));
+            chunkEnd = newline ? newline + 1 : dataEnd;
+        }
+
+        chunks[chunkIndex].begin = chunkBegin;
+        chunks[chunkIndex].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    ParallelFor(tasksCount, [&](int chunkIndex) {
+        ParseChunk(chunks[chunkIndex]);
+    });
+
+    QVector<int> chunkLineOffsets;
+
+    for (const auto& chunk : chunks) {
+        chunkLineOffsets.append(validation.linesCount);
+        validation.linesCount += static_cast<int>(chunk.lines.size());
+    }
+
+    ParallelFor(tasksCount, [&](int chunkIndex) {
+        auto& chunk = chunks[chunkIndex];
+
+        for (auto& line : chunk.lines) {
+            line.lineNumber += chunkLineOffsets[chunkIndex];
+        }
+
+        for (auto& finding : chunk.findings) {
+            finding.lineNumber += chunkLineOffsets[chunkIndex];
+        }
+    });
+
+    // Фреймы: каждый поток собирает свой раздел имён, обходя строки в порядке файла
+    std::vector<Partition> partitions(tasksCount);
+    const auto partitionsCount = static_cast<uint>(tasksCount);
+
+    ParallelFor(tasksCount, [&](int partitionIndex) {
+        auto& partition = partitions[partitionIndex];
+
+        for (auto& chunk : chunks) {
+            for (auto& line : chunk.lines) {
+                if (line.kind != LineKind::Frame || line.nameHash % partitionsCount != static_cast<uint>(partitionIndex))
+                    continue;
+
+                const auto frameIndexIt = partition.frameIndices.constFind(line.name);
+
+                if (frameIndexIt == partition.frameIndices.cend()) {
+                    partition.frameIndices.insert(line.name, partition.frameLines.size());
+                    partition.frameLines.append(&line);
+                    continue;
+                }
+
+                // Как и при загрузке, действует последнее объявление фрейма
+                auto*& declaredFrameLine = partition.frameLines[frameIndexIt.value()];
+                AddFinding(partition.findings, line, Severity::Error,
+                           QString("Фрейм \"%1\" уже объявлен в строке %2").arg(ToName(line.name)).arg(declaredFrameLine->lineNumber));
+                declaredFrameLine->isRemoved = true;
+                declaredFrameLine = &line;
+            }
+        }
+    });
+
+    QVector<int> frameIndexOffsets;
+
+    for (const auto& partition : partitions) {
+        frameIndexOffsets.append(validation.framesCount);
+        validation.framesCount += partition.frameLines.size();
+    }
+
+    frameIndexOffsets.append(validation.framesCount);
+
+    const auto findFrameIndex = [&](ByteView frameName, uint frameNameHash) {
+        const auto partitionIndex = frameNameHash % partitionsCount;
+        const auto& frameIndices = partitions[partitionIndex].frameIndices;
+        const auto frameIndexIt = frameIndices.constFind(frameName);
+        return frameIndexIt != frameIndices.cend() ? frameIndexOffsets[partitionIndex] + frameIndexIt.value() : -1;
+    };
+
+    // Слоты: раздел выбирается по хешу имени целевого фрейма, поэтому все слоты одного фрейма проверяет один поток
+    ParallelFor(tasksCount, [&](int partitionIndex) {
+        auto& partition = partitions[partitionIndex];
+        QHash<QPair<ByteView, ByteView>, ParsedLine*> declaredSlotLines; // [[FrameName, SlotName], действующее объявление]
+
+        for (auto& chunk : chunks) {
+            for (auto& line : chunk.lines) {
+                // isRemoved читается только после проверки раздела: строки других разделов в это время меняют их потоки
+                if (line.kind != LineKind::Slot || line.nameHash % partitionsCount != static_cast<uint>(partitionIndex) || line.isRemoved)
+                    continue;
+
+                if (findFrameIndex(line.name, line.nameHash) < 0) {
+                    line.isRemoved = true;
+                    AddFinding(partition.findings, line, Severity::Error,
+                               QString("Слот \"%1\" относится к необъявленному фрейму \"%2\"").arg(ToName(line.slotName), ToName(line.name)));
+                    continue;
+                }
+
+                if (line.isFrameReference && line.slotName == line.name) {
+                    line.isRemoved = true;
+                    AddFinding(partition.findings, line, Severity::Error, QString("Фрейм \"%1\" ссылается сам на себя").arg(ToName(line.name)));
+                    continue;
+                }
+
+                if (line.isFrameReference && findFrameIndex(line.slotName, line.slotNameHash) < 0) {
+                    line.isRemoved = true;
+                    AddFinding(partition.findings, line, Severity::Error,
+                               QString("Слот-фрейм фрейма \"%1\" ссылается на необъявленный фрейм \"%2\"").arg(ToName(line.name), ToName(line.slotName)));
+                    continue;
+                }
+
+                // Как и при загрузке, действует последнее объявление слота
+                auto*& declaredSlotLine = declaredSlotLines[qMakePair(line.name, line.slotName)];
+
+                if (declaredSlotLine) {
+                    AddFinding(partition.findings, line, Severity::Error, QString("Слот \"%1\" фрейма \"%2\" уже объявлен в строке %3").
+                               arg(ToName(line.slotName), ToName(line.name)).arg(declaredSlotLine->lineNumber));
+                    declaredSlotLine->isRemoved = true;
+                }
+
+                declaredSlotLine = &line;
+            }
+        }
+
+        partition.slotsCount = declaredSlotLines.size();
+
+        for (const auto* slotLine : qAsConst(declaredSlotLines)) {
+            if (slotLine->isFrameReference)
+                partition.referenceEdges.append({findFrameIndex(slotLine->name, slotLine->nameHash),
+                                                 findFrameIndex(slotLine->slotName, slotLine->slotNameHash), slotLine});
+        }
+    });
+
+    for (const auto& chunk : chunks) {
+        validation.findings += chunk.findings;
+
+        for (const auto& line : chunk.lines) {
+            validation.removedLinesCount += line.isRemoved;
+            validation.rewrittenLinesCount += line.isRewritten && !line.isRemoved;
+        }
+    }
+
+    for (const auto& partition : partitions) {
+        validation.slotsCount += partition.slotsCount;
+        validation.findings += partition.findings;
+    }
+
+    FindReferenceCycles(partitions, frameIndexOffsets, validation.findings);
+
+    std::stable_sort(validation.findings.begin(), validation.findings.end(), [](const Finding& lhs, const Finding& rhs) {
+        return lhs.lineNumber < rhs.lineNumber;
+    });
+
+    if (!repairedFilePath.isEmpty())
+        validation.isRepaired = WriteRepaired(repairedFilePath, chunks);
+
+    return validation;
+}
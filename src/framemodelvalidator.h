@@ -0,0 +1,38 @@
+#ifndef FRAMEMODELVALIDATOR_H
+#define FRAMEMODELVALIDATOR_H
+
+#include <QString>
+#include <QVector>
+
+// Результат проверки файла модели
+struct FrameModelValidation {
+    // Ошибки исправляются автоматически, предупреждения только сообщаются
+    enum class Severity { Warning, Error };
+
+    struct Finding {
+        int lineNumber;
+        Severity severity;
+        QString message;
+    };
+
+    QVector<Finding> findings; // По возрастанию номеров строк
+    int linesCount = 0, framesCount = 0, slotsCount = 0; // Фреймы и слоты — оставшиеся после исправления
+    int removedLinesCount = 0, rewrittenLinesCount = 0;
+    bool isFileOpened = false, isRepaired = false;
+
+    int GetErrorsCount() const;
+    QString ToText() const;
+};
+
+// Проверка файла модели (.fm) перед загрузкой: нераспознанные и неполные строки, координаты вне холста,
+// повторно объявленные фреймы и слоты, слоты несуществующих фреймов, слоты-фреймы, ссылающиеся
+// на несуществующий фрейм или на свой же фрейм, и циклы ссылок между фреймами. Файл отображается в память
+// и разбирается по частям параллельно, имена сравниваются как байты без перевода в QString, а проверка
+// имён разбита по хешу имени между потоками.
+// Если указан repairedFilePath, туда записывается исправленная модель: строки с ошибками удаляются,
+// координаты приводятся к холсту, а из повторных объявлений, как и при загрузке, остаётся последнее
+namespace FrameModelValidator {
+    FrameModelValidation Validate(const QString& filePath, const QString& repairedFilePath = QString());
+}
+
+#endif // FRAMEMODELVALIDATOR_H
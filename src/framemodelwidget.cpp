@@ -1,219 +1,530 @@
 #include "framemodelwidget.h"
+#include "profiler.h"
+#include <QMouseEvent>
 #include <QPainter>
+#include <QPaintEvent>
+#include <QRubberBand>
+#include <algorithm>
 #include <cmath>
 
-FrameModelWidget::FrameModelWidget(QWidget* parent) : QFrame(parent)
+FrameModelWidget::FrameModelWidget(QWidget* parent) : QFrame(parent), _rubberBand(new QRubberBand(QRubberBand::Rectangle, this))
 {
+    // Фокус нужен, чтобы узнать об открытии диалога или переключении окна посреди перетаскивания
+    setFocusPolicy(Qt::ClickFocus);
 }
 
-const FrameModelWidget::Frames& FrameModelWidget::GetFrames() const {
-    return _frames;
+void FrameModelWidget::SetModel(FrameModel* frameModel) {
+    FinishMouseGesture();
+
+    if (_frameModel)
+        disconnect(_frameModel, nullptr, this, nullptr);
+
+    _frameModel = frameModel;
+    _selectedFrames.clear();
+    InvalidateLayout();
+
+    if (!_frameModel)
+        return;
+
+    connect(_frameModel, &FrameModel::FrameAdded, this, &FrameModelWidget::OnFrameLayoutChanged);
+    connect(_frameModel, &FrameModel::FrameAboutToBeErased, this, &FrameModelWidget::OnFrameAboutToBeErased);
+    connect(_frameModel, &FrameModel::FramesAboutToBeUnloaded, this, &FrameModelWidget::OnFramesAboutToBeUnloaded);
+    connect(_frameModel, &FrameModel::FrameRenamed, this, &FrameModelWidget::OnFrameLayoutChanged);
+    connect(_frameModel, &FrameModel::FrameChanged, this, &FrameModelWidget::OnFrameLayoutChanged);
+    connect(_frameModel, &FrameModel::FrameMoved, this, &FrameModelWidget::OnFrameLayoutChanged);
+
+    connect(_frameModel, &FrameModel::ModelReset, this, [=]() {
+        FinishMouseGesture();
+        _selectedFrames.clear();
+        InvalidateLayout();
+    });
+
+    // После пакетного изменения модели холст раскладывается заново один раз, а не по сигналу на каждый фрейм
+    connect(_frameModel, &FrameModel::BulkUpdateFinished, this, &FrameModelWidget::InvalidateLayout);
 }
 
-QString FrameModelWidget::SyntaxSearch(const QStringList& syntaxSearchSlotNames) const {
-    const auto isNeedToSearchFrameReference = syntaxSearchSlotNames.contains("Фрейм-ссылка");
-    QString syntaxSearchResult = syntaxSearchSlotNames.join(", ").prepend("Результат синтаксического поиска для слотов \"").append("\":\n");
+const QSet<FrameHandle>& FrameModelWidget::GetSelectedFrames() const {
+    return _selectedFrames;
+}
 
-    for (const auto& [_, frameWithPosition] : _frames) {
-        const auto& frameSlots = frameWithPosition.first.GetSlots();
+qint64 FrameModelWidget::GetIndexBytes() const {
+    qint64 indexBytes = _frameGrid.GetBytes() + _arrowGrid.GetBytes();
 
-        for (const auto& [slotName, slotValueVariant] : frameSlots) {
-            if (isNeedToSearchFrameReference && std::holds_alternative<const Frame*>(slotValueVariant)) {
-                syntaxSearchResult.append("\"Фрейм-ссылка\"").append(" содержится во фрейме \"").append(frameWithPosition.first.GetName()).
-                                   append("\" со значением \"").append(std::get<const Frame*>(slotValueVariant)->GetName()).append("\"\n");
-            }
-            else if (std::holds_alternative<QString>(slotValueVariant) && syntaxSearchSlotNames.contains(slotName)) {
-                syntaxSearchResult.append('\"').append(slotName).append("\" содержится во фрейме \"").append(frameWithPosition.first.GetName()).
-                                   append("\" со значением \"").append(std::get<QString>(slotValueVariant)).append("\"\n");
-            }
+    for (const auto* references : {&_outgoingReferences, &_incomingReferences}) {
+        indexBytes += MemoryUsage::GetHashBytes(*references);
+
+        for (const auto& frameHandles : *references) {
+            indexBytes += static_cast<qint64>(frameHandles.capacity()) * sizeof(FrameHandle);
         }
     }
 
-    return syntaxSearchResult;
+    return indexBytes;
+}
+
+void FrameModelWidget::paintEvent(QPaintEvent* event) {
+    PROFILE_SCOPE("FrameModelWidget::paintEvent");
+
+    if (!_frameModel)
+        return;
+
+    EnsureLayout();
+
+    QPainter painter(this);
+    painter.setRenderHints(QPainter::Antialiasing);
+    painter.setBrush(QBrush(QColor(211, 223, 172))); // #d3dfac
+    painter.setFont(FrameFont());
+
+    // Рисуются только фреймы и стрелки, попадающие в обновляемую область, в неизменном порядке отрисовки,
+    // чтобы при частичной перерисовке перекрывающиеся фреймы выглядели так же, как при полной
+    const auto dirtyRect = event->rect().adjusted(-_repaintMargin, -_repaintMargin, _repaintMargin, _repaintMargin);
+    auto framesToDraw = _frameGrid.Query(dirtyRect);
+
+    std::sort(framesToDraw.begin(), framesToDraw.end(), [](FrameHandle left, FrameHandle right) {
+        return left.index < right.index;
+    });
+
+    for (const auto frameHandle : qAsConst(framesToDraw)) {
+        DrawFrame(painter, *_frameModel->Get(frameHandle), _frameGrid.Rect(frameHandle), _selectedFrames.contains(frameHandle));
+    }
+
+    PROFILE_COUNTER("FrameModelWidget::paintEvent: отрисовано фреймов", framesToDraw.size());
+
+    for (const auto& arrow : _arrowGrid.Query(dirtyRect)) {
+        const auto arrowLine = ArrowLine(_frameGrid.Rect(arrow.first), _frameGrid.Rect(arrow.second));
+        DrawLineWithArrow(painter, arrowLine.p1(), arrowLine.p2());
+    }
 }
 
-QString FrameModelWidget::SemanticSearch(const QStringList& semanticSearchSlotValues) const {
-    QString semanticSearchResult = semanticSearchSlotValues.join(", ").prepend("Результат семантического поиска для значения слотов \"").append("\":\n");
+void FrameModelWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton || !_frameModel) {
+        QFrame::mousePressEvent(event);
+        return;
+    }
+
+    EnsureLayout();
 
-    for (const auto& [_, frameWithPosition] : _frames) {
-        const auto slotsWithSearchValues = frameWithPosition.first.GetAllSlotsWithValues(semanticSearchSlotValues);
+    const auto oldSelection = _selectedFrames;
+    const bool isToggleSelection = event->modifiers() & Qt::ControlModifier;
+    const auto pressedFrameHandle = TopmostFrameAt(event->pos());
+    _mousePressPosition = event->pos();
 
-        if (!slotsWithSearchValues.isEmpty()) {
-            semanticSearchResult.append("Содержится во фрейме \"").append(frameWithPosition.first.GetName()).append("\":\n");
+    if (!pressedFrameHandle.IsNull()) {
+        if (isToggleSelection) {
+            if (!_selectedFrames.remove(pressedFrameHandle))
+                _selectedFrames.insert(pressedFrameHandle);
+        }
+        else if (!_selectedFrames.contains(pressedFrameHandle)) {
+            _selectedFrames = {pressedFrameHandle};
+        }
+
+        // Если щелчок пришёлся на выделенный фрейм, перетаскиваются все выделенные фреймы
+        if (_selectedFrames.contains(pressedFrameHandle)) {
+            _isDragging = true;
+            _dragStartPositions.clear();
 
-            for (const auto& slotSemanticSearchInfo : slotsWithSearchValues) {
-                semanticSearchResult.append("    — ").append(slotSemanticSearchInfo).append('\n');
+            for (const auto selectedFrameHandle : qAsConst(_selectedFrames)) {
+                _dragStartPositions.insert(selectedFrameHandle, _frameModel->GetPosition(selectedFrameHandle));
             }
+
+            emit DragStarted();
         }
+
+        EmitFrameSelected();
+    }
+    else {
+        _rubberBandBaseSelection = isToggleSelection ? _selectedFrames : QSet<FrameHandle>();
+        _selectedFrames = _rubberBandBaseSelection;
+        _rubberBand->setGeometry(QRect(_mousePressPosition, QSize()));
+        _rubberBand->show();
     }
 
-    return semanticSearchResult;
+    update(SelectionDirtyRect(oldSelection, _selectedFrames));
 }
 
-void FrameModelWidget::EraseFrame(const QString& erasableFrameName) {
-    for (auto& [frameName, frameWithPosition] : _frames) {
-        if (frameName != erasableFrameName) {
-            auto& frameSlots = frameWithPosition.first.GetSlots();
-            auto foundErasableFrameIt = frameSlots.find(erasableFrameName);
+void FrameModelWidget::mouseMoveEvent(QMouseEvent* event) {
+    if (_isDragging) {
+        const auto offset = event->pos() - _mousePressPosition;
 
-            // Если удаляемый фрейм найден, как слот в каком-то другом фрейме, удаляем его из слотов этого фрейма тоже
-            if (foundErasableFrameIt != frameSlots.end()) {
-                // Если найденный слот с именем erasableFrameName действительно является фреймом
-                // (ссылкой на фрейм, который удаляется), тогда удаляем его из списка слотов у рассматриваемого фрейма
-                if (std::holds_alternative<const Frame*>(foundErasableFrameIt->second)) {
-                    frameSlots.erase(foundErasableFrameIt);
-                }
-            }
+        _isBatchingRepaint = true;
+
+        for (auto dragStartIt = _dragStartPositions.cbegin(); dragStartIt != _dragStartPositions.cend(); ++dragStartIt) {
+            const QPoint newFramePosition(qBound(0, dragStartIt.value().x() + offset.x(), _maxFrameCoord),
+                                          qBound(0, dragStartIt.value().y() + offset.y(), _maxFrameCoord));
+            _frameModel->SetFramePosition(dragStartIt.key(), newFramePosition);
+        }
+
+        _isBatchingRepaint = false;
+        RepaintRects(_batchedDirtyRects);
+        _batchedDirtyRects.clear();
+    }
+    else if (_rubberBand->isVisible()) {
+        const auto rubberBandRect = QRect(_mousePressPosition, event->pos()).normalized();
+        _rubberBand->setGeometry(rubberBandRect);
+
+        auto newSelection = _rubberBandBaseSelection;
+
+        for (const auto frameHandle : _frameGrid.Query(rubberBandRect)) {
+            newSelection.insert(frameHandle);
         }
+
+        update(SelectionDirtyRect(_selectedFrames, newSelection));
+        _selectedFrames = std::move(newSelection);
+    }
+    else {
+        QFrame::mouseMoveEvent(event);
+    }
+}
+
+void FrameModelWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) {
+        QFrame::mouseReleaseEvent(event);
+        return;
+    }
+
+    const bool isRubberBandSelection = _rubberBand->isVisible();
+    FinishMouseGesture();
+
+    if (isRubberBandSelection)
+        EmitFrameSelected();
+}
+
+void FrameModelWidget::focusOutEvent(QFocusEvent* event) {
+    QFrame::focusOutEvent(event);
+    FinishMouseGesture();
+}
+
+void FrameModelWidget::hideEvent(QHideEvent* event) {
+    QFrame::hideEvent(event);
+    FinishMouseGesture();
+}
+
+void FrameModelWidget::showEvent(QShowEvent* event) {
+    QFrame::showEvent(event);
+
+    // Фреймы, хранящиеся вне модели, подгружаются, когда попадают в видимую область
+    if (_frameModel)
+        _frameModel->LoadArea(rect());
+}
+
+void FrameModelWidget::resizeEvent(QResizeEvent* event) {
+    QFrame::resizeEvent(event);
+
+    if (_frameModel && isVisible())
+        _frameModel->LoadArea(rect());
+}
+
+QFont FrameModelWidget::FrameFont() const {
+    QFont frameFont = font();
+    frameFont.setPixelSize(16);
+    return frameFont;
+}
+
+QRect FrameModelWidget::FrameRect(const Frame& frame, QPoint framePosition, const QFontMetrics& fontMetrics) {
+    const int rectWidth = fontMetrics.horizontalAdvance(frame.GetLongestFrameText()) + 40;
+    return QRect(framePosition, QSize(rectWidth, 75 + 20 * frame.GetSlots().Size()));
+}
+
+// Отпускание кнопки может не прийти (фокус или захват мыши ушёл к диалогу, модель сменилась), поэтому
+// перетаскивание завершается и в этих случаях: уже сделанные перемещения остаются одной правкой
+void FrameModelWidget::FinishMouseGesture() {
+    if (_rubberBand->isVisible()) {
+        _rubberBand->hide();
+        _rubberBandBaseSelection.clear();
     }
 
-    _frames.erase(erasableFrameName);
+    if (_isDragging) {
+        _isDragging = false;
+        _dragStartPositions.clear();
+        emit DragFinished();
+    }
 }
 
-void FrameModelWidget::ReplaceFrameName(const QString& oldFrameName, QString newFrameName) {
-    for (auto& [frameName, frameWithPosition] : _frames) {
-        if (frameName != oldFrameName) {
-            auto& frameSlots = frameWithPosition.first.GetSlots();
-            auto foundErasableFrameIt = frameSlots.find(oldFrameName);
+void FrameModelWidget::InvalidateLayout() {
+    _isLayoutDirty = true;
+    update();
+}
+
+void FrameModelWidget::EnsureLayout() {
+    if (!_isLayoutDirty)
+        return;
+
+    PROFILE_SCOPE("FrameModelWidget::EnsureLayout");
+
+    _frameGrid.Clear();
+    _arrowGrid.Clear();
+    _outgoingReferences.clear();
+    _incomingReferences.clear();
+
+    const QFontMetrics fontMetrics(FrameFont());
+    const auto& framePool = _frameModel->GetFramePool();
+
+    framePool.ForEach([&](FrameHandle frameHandle, const FramePool::Entry& entry) {
+        _frameGrid.Insert(frameHandle, FrameRect(entry.frame, entry.position, fontMetrics));
+    });
+
+    framePool.ForEach([&](FrameHandle frameHandle, const FramePool::Entry& entry) {
+        for (const auto& [_, slotValueVariant] : entry.frame.GetSlots()) {
+            const auto* targetFrameHandle = std::get_if<FrameHandle>(&slotValueVariant);
 
-            // Если изменяемый фрейм найден, как слот в каком-то другом фрейме, изменяем его имя (ключ) в слотах этого фрейма тоже
-            if (foundErasableFrameIt != frameSlots.end()) {
-                frameWithPosition.first.ReplaceSlotName(oldFrameName, newFrameName);
+            // Устаревшая ссылка (на фрейм, которого уже нет в пуле) стрелки не даёт
+            if (targetFrameHandle && _frameGrid.Contains(*targetFrameHandle)) {
+                const auto arrowLine = ArrowLine(_frameGrid.Rect(frameHandle), _frameGrid.Rect(*targetFrameHandle));
+
+                _outgoingReferences[frameHandle].append(*targetFrameHandle);
+                _incomingReferences[*targetFrameHandle].append(frameHandle);
+                _arrowGrid.InsertLine(Arrow(frameHandle, *targetFrameHandle), arrowLine, _arrowMargin);
             }
         }
-    }
+    });
 
-    auto node = _frames.extract(oldFrameName);
-    node.mapped().first.SetName(newFrameName);
-    node.key() = std::move(newFrameName);
-    _frames.insert(std::move(node));
+    _isLayoutDirty = false;
 }
 
-Frame& FrameModelWidget::At(const QString& frameName) {
-    return _frames.at(frameName).first;
+void FrameModelWidget::OnFrameAboutToBeErased(FrameHandle frameHandle) {
+    _selectedFrames.remove(frameHandle);
+    _rubberBandBaseSelection.remove(frameHandle);
+    _dragStartPositions.remove(frameHandle);
+
+    // Полная перерисовка уже запланирована, индексы будут перестроены при ней
+    if (_isLayoutDirty)
+        return;
+
+    QVector<QRect> dirtyRects;
+    RemoveFrameLayout(frameHandle, dirtyRects);
+    RepaintRects(dirtyRects);
 }
 
-bool FrameModelWidget::Contains(const QString& frameName) const {
-    return _frames.find(frameName) != _frames.end();
+void FrameModelWidget::OnFramesAboutToBeUnloaded(const QVector<FrameHandle>& frameHandles) {
+    QVector<QRect> dirtyRects;
+
+    for (const auto frameHandle : frameHandles) {
+        _selectedFrames.remove(frameHandle);
+        _rubberBandBaseSelection.remove(frameHandle);
+        _dragStartPositions.remove(frameHandle);
+
+        if (!_isLayoutDirty)
+            RemoveFrameLayout(frameHandle, dirtyRects);
+    }
+
+    RepaintRects(dirtyRects);
 }
 
-const Frame* FrameModelWidget::AddFrame(Frame frame, QPoint framePosition) {
-    auto& mappedElement = _frames[frame.GetName()];
-    mappedElement = std::make_pair(std::move(frame), framePosition);
-    return &mappedElement.first;
+void FrameModelWidget::OnFrameLayoutChanged(FrameHandle frameHandle) {
+    // После смены модели индексы всё равно будут перестроены целиком при отрисовке
+    if (_isLayoutDirty) {
+        update();
+        return;
+    }
+
+    if (_isBatchingRepaint) {
+        UpdateFrameLayout(frameHandle, _batchedDirtyRects);
+    }
+    else {
+        QVector<QRect> dirtyRects;
+        UpdateFrameLayout(frameHandle, dirtyRects);
+        RepaintRects(dirtyRects);
+    }
 }
 
-bool FrameModelWidget::IsEmpty() const {
-    return _frames.empty();
+FrameHandle FrameModelWidget::TopmostFrameAt(QPoint point) const {
+    FrameHandle topmostFrameHandle;
+
+    for (const auto frameHandle : _frameGrid.Query(QRect(point, QSize(1, 1)))) {
+        if (topmostFrameHandle.IsNull() || topmostFrameHandle.index < frameHandle.index)
+            topmostFrameHandle = frameHandle;
+    }
+
+    return topmostFrameHandle;
 }
 
-void FrameModelWidget::ReplaceFrameCoords(const QString& frameName, const QString& x, const QString& y) {
-    auto& [frame, frameCoords] = _frames.at(frameName);
+void FrameModelWidget::UpdateFrameLayout(FrameHandle frameHandle, QVector<QRect>& dirtyRects) {
+    const auto* frame = _frameModel->Get(frameHandle);
+
+    if (!frame)
+        return;
+
+    const auto margins = QMargins(_repaintMargin, _repaintMargin, _repaintMargin, _repaintMargin);
+    const auto newFrameRect = FrameRect(*frame, _frameModel->GetPosition(frameHandle), QFontMetrics(FrameFont()));
+
+    if (_frameGrid.Contains(frameHandle))
+        dirtyRects << _frameGrid.Rect(frameHandle).marginsAdded(margins);
 
-    if (!x.isEmpty()) frameCoords.setX(x.toInt());
-    if (!y.isEmpty()) frameCoords.setY(y.toInt());
+    _frameGrid.Insert(frameHandle, newFrameRect);
+    dirtyRects << newFrameRect.marginsAdded(margins);
+
+    auto updateArrow = [&](FrameHandle sourceFrameHandle, FrameHandle targetFrameHandle) {
+        const Arrow arrow(sourceFrameHandle, targetFrameHandle);
+
+        dirtyRects << _arrowGrid.Rect(arrow);
+        _arrowGrid.InsertLine(arrow, ArrowLine(_frameGrid.Rect(sourceFrameHandle), _frameGrid.Rect(targetFrameHandle)), _arrowMargin);
+        dirtyRects << _arrowGrid.Rect(arrow);
+    };
+
+    // Исходящие стрелки заново строятся по текущим слотам фрейма, а входящие только меняют геометрию
+    RemoveOutgoingArrows(frameHandle, dirtyRects);
+
+    for (const auto& [_, slotValueVariant] : frame->GetSlots()) {
+        const auto* targetFrameHandle = std::get_if<FrameHandle>(&slotValueVariant);
+
+        if (targetFrameHandle && _frameGrid.Contains(*targetFrameHandle)) {
+            _outgoingReferences[frameHandle].append(*targetFrameHandle);
+            _incomingReferences[*targetFrameHandle].append(frameHandle);
+            updateArrow(frameHandle, *targetFrameHandle);
+        }
+    }
+
+    for (const auto sourceFrameHandle : _incomingReferences.value(frameHandle)) {
+        updateArrow(sourceFrameHandle, frameHandle);
+    }
 }
 
-void FrameModelWidget::paintEvent(QPaintEvent*) {
-    QPainter painter(this);
-    painter.setRenderHints(QPainter::Antialiasing);
-    painter.setBrush(QBrush(QColor(211, 223, 172))); // #d3dfac
+void FrameModelWidget::RemoveFrameLayout(FrameHandle frameHandle, QVector<QRect>& dirtyRects) {
+    const auto margins = QMargins(_repaintMargin, _repaintMargin, _repaintMargin, _repaintMargin);
 
-    QFont font = painter.font();
-    font.setPixelSize(16);
-    painter.setFont(font);
+    dirtyRects << _frameGrid.Rect(frameHandle).marginsAdded(margins);
+    _frameGrid.Remove(frameHandle);
+    RemoveOutgoingArrows(frameHandle, dirtyRects);
 
-    for (const auto& [_, frameWithPosition] : _frames) {
-        const auto frameInfoText = frameWithPosition.first.GetInfoText();
-        const auto longestFrameText = frameWithPosition.first.GetLongestFrameText();
+    // Фреймы, ссылавшиеся на удаляемый, сами получат FrameChanged, когда модель уберёт у них эти слоты
+    for (const auto sourceFrameHandle : _incomingReferences.take(frameHandle)) {
+        const Arrow arrow(sourceFrameHandle, frameHandle);
 
-        QFontMetrics fontMetrics(font);
-        const int rectWidth = fontMetrics.horizontalAdvance(longestFrameText) + 40;
+        dirtyRects << _arrowGrid.Rect(arrow);
+        _arrowGrid.Remove(arrow);
 
-        const auto sourceFrameRect = QRect(frameWithPosition.second, QSize(rectWidth, 75 + 20 * frameWithPosition.first.GetSlots().size()));
-        auto tmpFrameRect = sourceFrameRect;
+        const auto outgoingIt = _outgoingReferences.find(sourceFrameHandle);
 
-        painter.drawRect(tmpFrameRect);
+        if (outgoingIt != _outgoingReferences.end()) {
+            outgoingIt->removeOne(frameHandle);
 
-        tmpFrameRect.setTop(tmpFrameRect.y() - tmpFrameRect.height() + 35);
-        painter.drawText(tmpFrameRect, Qt::AlignCenter, frameInfoText);
+            if (outgoingIt->isEmpty())
+                _outgoingReferences.erase(outgoingIt);
+        }
+    }
+}
 
-        tmpFrameRect.setTop(tmpFrameRect.y() + tmpFrameRect.height() * 0.5 + 15);
-        painter.drawLine(QPoint(tmpFrameRect.x() + 15, tmpFrameRect.y()), QPoint(tmpFrameRect.x() + tmpFrameRect.width() - 15, tmpFrameRect.y()));
+void FrameModelWidget::RemoveOutgoingArrows(FrameHandle frameHandle, QVector<QRect>& dirtyRects) {
+    for (const auto targetFrameHandle : _outgoingReferences.take(frameHandle)) {
+        const Arrow arrow(frameHandle, targetFrameHandle);
 
-        tmpFrameRect.setTop(tmpFrameRect.y() + 5);
-        tmpFrameRect.setLeft(tmpFrameRect.x() + 15);
+        dirtyRects << _arrowGrid.Rect(arrow);
+        _arrowGrid.Remove(arrow);
 
-        font.setBold(true); painter.setFont(font);
-        painter.drawText(tmpFrameRect, Qt::AlignLeft, "Слоты:");
-        font.setBold(false); painter.setFont(font);
+        const auto incomingIt = _incomingReferences.find(targetFrameHandle);
 
-        DrawSlots(painter, frameWithPosition.first.GetSlots(), sourceFrameRect, tmpFrameRect);
+        if (incomingIt != _incomingReferences.end()) {
+            incomingIt->removeOne(frameHandle);
+
+            if (incomingIt->isEmpty())
+                _incomingReferences.erase(incomingIt);
+        }
     }
 }
 
-void FrameModelWidget::DrawSlots(QPainter& painter, const Frame::Slots& frameSlots, const QRect& sourceFrameRect, QRect& tmpFrameRect) {
-    for (const auto& [slotName, frameSlotVariant] : frameSlots) {
-        QString slotInfoText;
-        const Frame* slotFrame = nullptr;
+void FrameModelWidget::RepaintRects(const QVector<QRect>& dirtyRects) {
+    // Объединение большого числа прямоугольников в QRegion обходится дороже, чем перерисовка их общей рамки
+    if (dirtyRects.size() <= _maxDirtyRects) {
+        QRegion dirtyRegion;
 
-        if (std::holds_alternative<QString>(frameSlotVariant)) {
-            slotInfoText.append(slotName).append(" (").append(std::get<QString>(frameSlotVariant)).append(')');
+        for (const auto& dirtyRect : dirtyRects) {
+            dirtyRegion += dirtyRect;
         }
-        else {
-            slotFrame = std::get<const Frame*>(frameSlotVariant);
-            slotInfoText.prepend("Фрейм-ссылка (\"").append(slotFrame->GetName()).append("\")");
+
+        update(dirtyRegion);
+    }
+    else {
+        QRect dirtyBoundingRect;
+
+        for (const auto& dirtyRect : dirtyRects) {
+            dirtyBoundingRect |= dirtyRect;
         }
 
-        tmpFrameRect.setTop(tmpFrameRect.y() + 20);
-        painter.drawText(tmpFrameRect, Qt::AlignLeft, slotInfoText);
-
-        if (slotFrame) {
-            const auto slotFrameHeight = 75 + 20 * slotFrame->GetSlots().size();
-            auto slotFramePosition = _frames.at(slotFrame->GetName()).second;
-
-            if (slotFramePosition.x() >= sourceFrameRect.x() + sourceFrameRect.width() * 0.5) {
-                if (slotFramePosition.x() <= sourceFrameRect.x() + sourceFrameRect.width() &&
-                    slotFramePosition.y() > sourceFrameRect.y() + sourceFrameRect.height())
-                {
-                    DrawLineWithArrow(painter, sourceFrameRect.bottomRight(), slotFramePosition);
-                }
-                else {
-                    slotFramePosition.setY(slotFramePosition.y() + slotFrameHeight);
-                    DrawLineWithArrow(painter, sourceFrameRect.topRight(), slotFramePosition);
-                }
-            }
-            else {
-                QFontMetrics fontMetrics(painter.font());
-                const int slotFrameRectWidth = fontMetrics.horizontalAdvance(slotFrame->GetLongestFrameText()) + 40;
-
-                if (slotFramePosition.x() + slotFrameRectWidth >= sourceFrameRect.x() &&
-                    slotFramePosition.y() > sourceFrameRect.y() + sourceFrameRect.height())
-                {
-                    slotFramePosition.setX(slotFramePosition.x() + slotFrameRectWidth);
-                    DrawLineWithArrow(painter, sourceFrameRect.bottomLeft(), slotFramePosition);
-                }
-                else {
-                    slotFramePosition.setX(slotFramePosition.x() + slotFrameRectWidth);
-                    slotFramePosition.setY(slotFramePosition.y() + slotFrameHeight);
-                    DrawLineWithArrow(painter, sourceFrameRect.topLeft(), slotFramePosition);
-                }
-            }
+        update(dirtyBoundingRect);
+    }
+}
+
+QRect FrameModelWidget::SelectionDirtyRect(const QSet<FrameHandle>& oldSelection, const QSet<FrameHandle>& newSelection) const {
+    QRect dirtyRect;
+
+    for (const auto* selection : {&oldSelection, &newSelection}) {
+        const auto* otherSelection = selection == &oldSelection ? &newSelection : &oldSelection;
+
+        for (const auto frameHandle : *selection) {
+            if (!otherSelection->contains(frameHandle))
+                dirtyRect |= _frameGrid.Rect(frameHandle);
         }
     }
+
+    return dirtyRect.adjusted(-_repaintMargin, -_repaintMargin, _repaintMargin, _repaintMargin);
 }
 
-void FrameModelWidget::DrawLineWithArrow(QPainter& painter, QPoint start, QPoint end) {
-    constexpr double arrowHeadSize = 10; // Размер треугольника на конце стрелки
+void FrameModelWidget::EmitFrameSelected() {
+    if (_selectedFrames.size() != 1)
+        return;
+
+    if (const auto* selectedFrame = _frameModel->Get(*_selectedFrames.cbegin()))
+        emit FrameSelected(selectedFrame->GetName());
+}
+
+void FrameModelWidget::DrawFrame(QPainter& painter, const Frame& frame, const QRect& sourceFrameRect, bool isSelected) {
+    auto tmpFrameRect = sourceFrameRect;
+
+    painter.save();
 
+    if (isSelected)
+        painter.setPen(QPen(QColor(37, 99, 235), 3)); // #2563eb
+
+    painter.drawRect(tmpFrameRect);
+    painter.restore();
+
+    tmpFrameRect.setTop(tmpFrameRect.y() - tmpFrameRect.height() + 35);
+    painter.drawText(tmpFrameRect, Qt::AlignCenter, frame.GetInfoText());
+
+    tmpFrameRect.setTop(tmpFrameRect.y() + tmpFrameRect.height() * 0.5 + 15);
+    painter.drawLine(QPoint(tmpFrameRect.x() + 15, tmpFrameRect.y()), QPoint(tmpFrameRect.x() + tmpFrameRect.width() - 15, tmpFrameRect.y()));
+
+    tmpFrameRect.setTop(tmpFrameRect.y() + 5);
+    tmpFrameRect.setLeft(tmpFrameRect.x() + 15);
+
+    QFont font = painter.font();
+    font.setBold(true); painter.setFont(font);
+    painter.drawText(tmpFrameRect, Qt::AlignLeft, "Слоты:");
+    font.setBold(false); painter.setFont(font);
+
+    for (const auto& slot : frame.GetSlots()) {
+        tmpFrameRect.setTop(tmpFrameRect.y() + 20);
+        painter.drawText(tmpFrameRect, Qt::AlignLeft, Frame::GetSlotInfoText(slot));
+    }
+}
+
+QLine FrameModelWidget::ArrowLine(const QRect& sourceFrameRect, const QRect& targetFrameRect) {
+    // Стрелка выходит из угла фрейма-источника и указывает на ближайший к нему угол фрейма-ссылки
+    const auto& source = sourceFrameRect;
+    const auto& target = targetFrameRect;
+
+    if (target.x() >= source.x() + source.width() * 0.5) {
+        if (target.x() <= source.x() + source.width() && target.y() > source.y() + source.height())
+            return QLine(source.bottomRight(), target.topLeft());
+        else
+            return QLine(source.topRight(), QPoint(target.x(), target.y() + target.height()));
+    }
+    else {
+        if (target.x() + target.width() >= source.x() && target.y() > source.y() + source.height())
+            return QLine(source.bottomLeft(), QPoint(target.x() + target.width(), target.y()));
+        else
+            return QLine(source.topLeft(), QPoint(target.x() + target.width(), target.y() + target.height()));
+    }
+}
+
+void FrameModelWidget::DrawLineWithArrow(QPainter& painter, QPoint start, QPoint end) {
     painter.save();
     painter.setPen(Qt::black);
     painter.setBrush(Qt::black);
 
     const QLineF line(end, start);
     const double angle = std::atan2(-line.dy(), line.dx());
-    const QPointF arrowP1 = line.p1() + QPointF(std::sin(angle + M_PI / 3) * arrowHeadSize, std::cos(angle + M_PI / 3) * arrowHeadSize);
-    const QPointF arrowP2 = line.p1() + QPointF(std::sin(angle + M_PI - M_PI / 3) * arrowHeadSize, std::cos(angle + M_PI - M_PI / 3) * arrowHeadSize);
+    const QPointF arrowP1 = line.p1() + QPointF(std::sin(angle + M_PI / 3) * _arrowHeadSize, std::cos(angle + M_PI / 3) * _arrowHeadSize);
+    const QPointF arrowP2 = line.p1() + QPointF(std::sin(angle + M_PI - M_PI / 3) * _arrowHeadSize, std::cos(angle + M_PI - M_PI / 3) * _arrowHeadSize);
 
     QPolygonF arrowHead;
     arrowHead.clear();
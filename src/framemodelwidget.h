@@ -1,38 +1,92 @@
 #ifndef FRAMEMODELWIDGET_H
 #define FRAMEMODELWIDGET_H
 
-#include "frame.h"
+#include "framemodel.h"
+#include "spatialgrid.h"
 #include <QFrame>
+#include <QSet>
 
 class QPainter;
+class QRubberBand;
 
 class FrameModelWidget : public QFrame {
     Q_OBJECT
 
 public:
-    // [FrameName, [Frame, FramePosition]]
-    using Frames = std::unordered_map<QString, std::pair<Frame, QPoint>>;
-
     explicit FrameModelWidget(QWidget* parent = nullptr);
-    const Frames& GetFrames() const;
-    QString SyntaxSearch(const QStringList& syntaxSearchSlotNames) const;
-    QString SemanticSearch(const QStringList& semanticSearchSlotValues) const;
-    Frame& At(const QString& frameName);
-    bool Contains(const QString& frameName) const;
-    const Frame* AddFrame(Frame frame, QPoint framePosition);
-    bool IsEmpty() const;
-    void ReplaceFrameCoords(const QString& frameName, const QString& x, const QString& y);
-    void EraseFrame(const QString& erasableFrameName);
-    void ReplaceFrameName(const QString& oldFrameName, QString newFrameName);
+    void SetModel(FrameModel* frameModel);
+    const QSet<FrameHandle>& GetSelectedFrames() const;
+    qint64 GetIndexBytes() const;
+
+signals:
+    // Испускается, когда щелчком мыши выбран ровно один фрейм
+    void FrameSelected(const QString& frameName);
+    // Начало и конец перетаскивания выделенных фреймов: все перемещения между ними — одна правка.
+    // DragFinished испускается и для прерванного перетаскивания, поэтому каждому DragStarted соответствует ровно один
+    void DragStarted();
+    void DragFinished();
 
 protected:
-    void paintEvent(QPaintEvent*) override;
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void focusOutEvent(QFocusEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
 
 private:
-    // [FrameName, [Frame, FramePosition]]
-    Frames _frames;
+    // [SourceFrameHandle, TargetFrameHandle]
+    using Arrow = QPair<FrameHandle, FrameHandle>;
+
+    FrameModel* _frameModel = nullptr;
+
+    // Пространственные индексы прямоугольников фреймов и стрелок между ними, а также прямые
+    // [SourceFrameHandle, TargetFrameHandles] и обратные [TargetFrameHandle, SourceFrameHandles] ссылки.
+    // Целиком строятся лениво при первой отрисовке после смены модели, а при добавлении, изменении,
+    // перемещении и удалении фрейма обновляются только для него самого и его стрелок.
+    // Порядок отрисовки: сначала все фреймы в порядке их записей в FramePool, затем поверх них все стрелки.
+    // Стрелка, проходящая через чужой фрейм, видна поверх него, а не скрыта под ним, как когда стрелки фрейма
+    // рисовались сразу после него самого
+    SpatialGrid<FrameHandle> _frameGrid;
+    SpatialGrid<Arrow> _arrowGrid;
+    QHash<FrameHandle, QVector<FrameHandle>> _outgoingReferences, _incomingReferences;
+    bool _isLayoutDirty = true;
+
+    QSet<FrameHandle> _selectedFrames, _rubberBandBaseSelection;
+    QHash<FrameHandle, QPoint> _dragStartPositions;
+    QPoint _mousePressPosition;
+    QRubberBand* _rubberBand = nullptr;
+    bool _isDragging = false;
+    // Пока перемещается группа фреймов, области перерисовки копятся и отдаются в update() один раз
+    QVector<QRect> _batchedDirtyRects;
+    bool _isBatchingRepaint = false;
+
+    inline static constexpr int _maxFrameCoord = 9999; // Координаты фреймов вводятся не более чем четырьмя цифрами
+    inline static constexpr int _repaintMargin = 4; // Запас на толщину обводки и сглаживание при частичной перерисовке
+    inline static constexpr int _maxDirtyRects = 64;
+    inline static constexpr double _arrowHeadSize = 10; // Размер треугольника на конце стрелки
+    // Стрелка индексируется отрезком с запасом на наконечник и сглаживание
+    inline static constexpr int _arrowMargin = static_cast<int>(_arrowHeadSize) + _repaintMargin;
 
-    void DrawSlots(QPainter& painter, const Frame::Slots& frameSlots, const QRect& sourceFrameRect, QRect& tmpFrameRect);
+    QFont FrameFont() const;
+    static QRect FrameRect(const Frame& frame, QPoint framePosition, const QFontMetrics& fontMetrics);
+    void FinishMouseGesture();
+    void InvalidateLayout();
+    void EnsureLayout();
+    void OnFrameAboutToBeErased(FrameHandle frameHandle);
+    void OnFramesAboutToBeUnloaded(const QVector<FrameHandle>& frameHandles);
+    void OnFrameLayoutChanged(FrameHandle frameHandle);
+    FrameHandle TopmostFrameAt(QPoint point) const;
+    void UpdateFrameLayout(FrameHandle frameHandle, QVector<QRect>& dirtyRects);
+    void RemoveFrameLayout(FrameHandle frameHandle, QVector<QRect>& dirtyRects);
+    void RemoveOutgoingArrows(FrameHandle frameHandle, QVector<QRect>& dirtyRects);
+    void RepaintRects(const QVector<QRect>& dirtyRects);
+    QRect SelectionDirtyRect(const QSet<FrameHandle>& oldSelection, const QSet<FrameHandle>& newSelection) const;
+    void EmitFrameSelected();
+    void DrawFrame(QPainter& painter, const Frame& frame, const QRect& sourceFrameRect, bool isSelected);
+    static QLine ArrowLine(const QRect& sourceFrameRect, const QRect& targetFrameRect);
     static void DrawLineWithArrow(QPainter& painter, QPoint start, QPoint end);
 };
 
@@ -0,0 +1,95 @@
+#include "framepool.h"
+
+void FramePool::Reserve(int count) {
+    while (static_cast<qint64>(_slabs.size()) * _slabSize < count)
+        AllocateSlab();
+}
+
+FrameHandle FramePool::Create(Frame frame, QPoint position) {
+    quint32 index;
+
+    if (!_freeIndices.isEmpty()) {
+        index = _freeIndices.takeLast();
+    }
+    else {
+        if (_usedRecords == _slabs.size() * _slabSize)
+            AllocateSlab();
+
+        index = _usedRecords++;
+    }
+
+    auto& record = RecordAt(index);
+    record.entry = {std::move(frame), position};
+    record.isAlive = true;
+    ++_aliveCount;
+
+    return {index, record.generation};
+}
+
+bool FramePool::Release(FrameHandle frameHandle) {
+    if (!IsValid(frameHandle))
+        return false;
+
+    auto& record = RecordAt(frameHandle.index);
+    record.entry = Entry();
+    record.isAlive = false;
+    _maxGeneration = qMax(_maxGeneration, ++record.generation);
+    _freeIndices.append(frameHandle.index);
+    --_aliveCount;
+
+    return true;
+}
+
+bool FramePool::IsValid(FrameHandle frameHandle) const {
+    if (frameHandle.index >= _usedRecords)
+        return false;
+
+    const auto& record = RecordAt(frameHandle.index);
+    return record.isAlive && record.generation == frameHandle.generation;
+}
+
+FramePool::Entry* FramePool::Get(FrameHandle frameHandle) {
+    return IsValid(frameHandle) ? &RecordAt(frameHandle.index).entry : nullptr;
+}
+
+const FramePool::Entry* FramePool::Get(FrameHandle frameHandle) const {
+    return IsValid(frameHandle) ? &RecordAt(frameHandle.index).entry : nullptr;
+}
+
+int FramePool::Size() const {
+    return _aliveCount;
+}
+
+bool FramePool::IsEmpty() const {
+    return _aliveCount == 0;
+}
+
+void FramePool::Clear() {
+    _slabs.clear();
+    _freeIndices.clear();
+    _usedRecords = 0;
+    _aliveCount = 0;
+    _generationBase = _maxGeneration = _maxGeneration + 1;
+}
+
+qint64 FramePool::GetBytes() const {
+    return static_cast<qint64>(_slabs.size()) * _slabSize * sizeof(Record) + static_cast<qint64>(_freeIndices.capacity()) * sizeof(quint32);
+}
+
+FramePool::Record& FramePool::RecordAt(quint32 index) {
+    return _slabs[index / _slabSize][index % _slabSize];
+}
+
+const FramePool::Record& FramePool::RecordAt(quint32 index) const {
+    return _slabs[index / _slabSize][index % _slabSize];
+}
+
+void FramePool::AllocateSlab() {
+    auto slab = std::make_unique<Record[]>(_slabSize);
+
+    for (quint32 index = 0; index < _slabSize; ++index) {
+        slab[index].generation = _generationBase;
+    }
+
+    _slabs.push_back(std::move(slab));
+}
@@ -0,0 +1,77 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include "frame.h"
+#include <QPoint>
+#include <memory>
+#include <vector>
+
+// Пул фреймов, размещённых в слэбах фиксированного размера. Записи не перемещаются при росте пула,
+// обход идёт по непрерывным массивам, а массовая загрузка и очистка сводятся к нескольким крупным
+// выделениям и освобождениям памяти. Доступ к фреймам — только по FrameHandle с проверкой поколения
+class FramePool {
+public:
+    struct Entry {
+        Frame frame;
+        QPoint position;
+    };
+
+    FramePool() = default;
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    void Reserve(int count);
+    FrameHandle Create(Frame frame, QPoint position);
+    bool Release(FrameHandle frameHandle);
+    bool IsValid(FrameHandle frameHandle) const;
+    Entry* Get(FrameHandle frameHandle);
+    const Entry* Get(FrameHandle frameHandle) const;
+    int Size() const;
+    bool IsEmpty() const;
+    void Clear();
+    qint64 GetBytes() const;
+
+    // Обход живых записей в порядке индексов: callback(FrameHandle, Entry&)
+    template <typename Callback>
+    void ForEach(Callback callback) {
+        for (quint32 index = 0; index < _usedRecords; ++index) {
+            auto& record = RecordAt(index);
+
+            if (record.isAlive)
+                callback(FrameHandle{index, record.generation}, record.entry);
+        }
+    }
+
+    template <typename Callback>
+    void ForEach(Callback callback) const {
+        for (quint32 index = 0; index < _usedRecords; ++index) {
+            const auto& record = RecordAt(index);
+
+            if (record.isAlive)
+                callback(FrameHandle{index, record.generation}, static_cast<const Entry&>(record.entry));
+        }
+    }
+
+private:
+    struct Record {
+        Entry entry;
+        quint32 generation = 0;
+        bool isAlive = false;
+    };
+
+    inline static constexpr quint32 _slabSize = 4096;
+
+    std::vector<std::unique_ptr<Record[]>> _slabs;
+    quint32 _usedRecords = 0; // Записи с индексами не меньше этого ещё ни разу не выдавались
+    QVector<quint32> _freeIndices;
+    int _aliveCount = 0;
+    // Поколение, с которого начинаются записи новых слэбов. После Clear оно становится больше любого
+    // выданного ранее, чтобы ссылки, полученные до очистки, не стали снова действительными
+    quint32 _generationBase = 0, _maxGeneration = 0;
+
+    Record& RecordAt(quint32 index);
+    const Record& RecordAt(quint32 index) const;
+    void AllocateSlab();
+};
+
+#endif // FRAMEPOOL_H
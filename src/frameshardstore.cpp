@@ -0,0 +1,522 @@
+#include "frameshardstore.h"
+#include "framemodelfile.h"
+#include "profiler.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <algorithm>
+
+FrameShardStore::FrameShardStore(FrameModel* frameModel, QObject* parent) : QObject(parent), _frameModel(frameModel)
+{
+}
+
+bool FrameShardStore::Open(const QString& manifestPath) {
+/* |  0 |     1     | 2 | 3 |  4  |  5  |   <--- Индексы в записи манифеста
+ *  Шард model_0.fm  0   0  1020   980     <--- Так хранится запись о шарде: файл и границы позиций его фреймов (x, y, ширина, высота)
+ */
+
+/* |  0  |    1   | 2 |   <--- Индексы в записи индекса
+ *  Фрейм Водитель 0      <--- Так хранится запись о фрейме: имя и номер шарда в манифесте
+ */
+
+    PROFILE_SCOPE("FrameShardStore::Open");
+
+    QFile manifestFile(manifestPath);
+
+    if (!manifestFile.open(QFile::ReadOnly))
+        return false;
+
+    disconnect(_frameModel, nullptr, this, nullptr);
+    _manifestPath = manifestPath;
+    _shards.clear();
+    _frameShards.clear();
+    _loadedFrames.clear();
+    _loadedBytes = 0;
+
+    QTextStream manifestIn(&manifestFile);
+
+    while (!manifestIn.atEnd()) {
+        const auto splitLine = manifestIn.readLine().split(' ');
+
+        if (splitLine[0] == "Шард" && splitLine.size() >= 6) {
+            Shard shard;
+            shard.fileName = splitLine[1];
+            shard.bounds = QRect(splitLine[2].toInt(), splitLine[3].toInt(), splitLine[4].toInt(), splitLine[5].toInt());
+            _shards.append(shard);
+        }
+    }
+
+    QFile indexFile(GetIndexPath(_manifestPath));
+
+    if (indexFile.open(QFile::ReadOnly)) {
+        QTextStream indexIn(&indexFile);
+
+        while (!indexIn.atEnd()) {
+            auto splitLine = indexIn.readLine().split(' ');
+            bool isShardIndexValid = false;
+            const int shardIndex = splitLine.size() >= 3 ? splitLine[2].toInt(&isShardIndexValid) : -1;
+
+            if (splitLine[0] == "Фрейм" && isShardIndexValid && shardIndex >= 0 && shardIndex < _shards.size())
+                _frameShards.insert(splitLine[1].replace('_', ' '), shardIndex);
+        }
+    }
+    else {
+        // Без индекса он восстанавливается по строкам фреймов самих шардов
+        for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+            QFile shardFile(GetShardFilePath(shardIndex));
+
+            if (!shardFile.open(QFile::ReadOnly))
+                continue;
+
+            QTextStream shardIn(&shardFile);
+            FrameModelBatch batch;
+
+            while (!shardIn.atEnd()) {
+                FrameModelFile::ParseLine(shardIn.readLine(), batch);
+            }
+
+            for (const auto& frameRecord : qAsConst(batch.frameRecords)) {
+                _frameShards.insert(frameRecord.name, shardIndex);
+            }
+        }
+    }
+
+    connect(_frameModel, &FrameModel::FrameAdded, this, &FrameShardStore::OnFrameAdded);
+    connect(_frameModel, &FrameModel::FrameAboutToBeErased, this, &FrameShardStore::OnFrameAboutToBeErased);
+    connect(_frameModel, &FrameModel::FrameRenamed, this, &FrameShardStore::OnFrameRenamed);
+    connect(_frameModel, &FrameModel::FrameChanged, this, &FrameShardStore::OnFrameChanged);
+    connect(_frameModel, &FrameModel::FrameMoved, this, &FrameShardStore::OnFrameChanged);
+
+    return true;
+}
+
+bool FrameShardStore::IsOpen() const {
+    return !_manifestPath.isEmpty();
+}
+
+bool FrameShardStore::Save() {
+    PROFILE_SCOPE("FrameShardStore::Save");
+
+    if (!IsOpen())
+        return false;
+
+    bool isSaved = true;
+
+    // Выгруженные шарды были записаны перед выгрузкой
+    for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+        if (_shards[shardIndex].isLoaded && _shards[shardIndex].isDirty)
+            isSaved = WriteShard(shardIndex) && isSaved;
+    }
+
+    return WriteManifest(_manifestPath, _shards) && WriteIndex(GetIndexPath(_manifestPath), _frameShards) && isSaved;
+}
+
+void FrameShardStore::SetMemoryBudget(qint64 memoryBudget) {
+    _memoryBudget = memoryBudget;
+    ScheduleEviction();
+}
+
+int FrameShardStore::GetShardsCount() const {
+    return _shards.size();
+}
+
+int FrameShardStore::GetFramesCount() const {
+    return _frameShards.size();
+}
+
+bool FrameShardStore::LoadFrame(const QString& frameName) {
+    const auto frameShardIt = _frameShards.constFind(frameName);
+
+    if (frameShardIt == _frameShards.constEnd() || _shards[frameShardIt.value()].isLoaded)
+        return false;
+
+    LoadShard(frameShardIt.value());
+    ScheduleEviction();
+    return true;
+}
+
+void FrameShardStore::LoadArea(const QRect& area) {
+    const auto searchArea = area.adjusted(-_frameExtentMargin, -_frameExtentMargin, 0, 0);
+
+    for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+        if (_shards[shardIndex].bounds.intersects(searchArea)) {
+            if (!_shards[shardIndex].isLoaded)
+                LoadShard(shardIndex);
+
+            TouchShard(shardIndex);
+        }
+    }
+
+    ScheduleEviction();
+}
+
+void FrameShardStore::ForEachPart(const std::function<void(const QVector<FrameHandle>&)>& visitor) {
+    PROFILE_SCOPE("FrameShardStore::ForEachPart");
+
+    // Бюджет памяти соблюдается и при обходе: перед переходом к следующему шарду лишние выгружаются
+    for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+        if (!_shards[shardIndex].isLoaded)
+            LoadShard(shardIndex);
+
+        TouchShard(shardIndex);
+        visitor(QVector<FrameHandle>(_shards[shardIndex].frameHandles));
+        EnforceMemoryBudget(shardIndex);
+    }
+}
+
+QStringList FrameShardStore::GetFrameNames() const {
+    return _frameShards.keys();
+}
+
+bool FrameShardStore::Write(const FrameModel& frameModel, const QString& manifestPath, int framesPerShard) {
+    PROFILE_SCOPE("FrameShardStore::Write");
+
+    QVector<FrameHandle> frameHandles;
+    QVector<Shard> shards;
+    QHash<QString, int> frameShards;
+
+    frameModel.GetFramePool().ForEach([&](FrameHandle frameHandle, const FramePool::Entry&) {
+        frameHandles.append(frameHandle);
+    });
+
+    // Фреймы упорядочиваются по квадратам холста, чтобы видимая область затрагивала как можно меньше шардов
+    auto tileOf = [&](FrameHandle frameHandle) {
+        const auto framePosition = frameModel.GetPosition(frameHandle);
+        return qMakePair(qMax(0, framePosition.y()) / _tileSize, qMax(0, framePosition.x()) / _tileSize);
+    };
+
+    std::stable_sort(frameHandles.begin(), frameHandles.end(), [&](FrameHandle left, FrameHandle right) {
+        return tileOf(left) < tileOf(right);
+    });
+
+    for (int firstFrame = 0; firstFrame < frameHandles.size(); firstFrame += framesPerShard) {
+        const auto shardFrameHandles = frameHandles.mid(firstFrame, framesPerShard);
+        Shard shard;
+        shard.fileName = GetShardFileName(manifestPath, shards.size());
+
+        if (!WriteShardFile(QFileInfo(manifestPath).dir().filePath(shard.fileName), frameModel, shardFrameHandles, shard.bounds))
+            return false;
+
+        for (const auto frameHandle : shardFrameHandles) {
+            frameShards.insert(frameModel.Get(frameHandle)->GetName(), shards.size());
+        }
+
+        shards.append(shard);
+    }
+
+    return WriteManifest(manifestPath, shards) && WriteIndex(GetIndexPath(manifestPath), frameShards);
+}
+
+QString FrameShardStore::GetManifestPath(const QString& modelFilePath) {
+    const QFileInfo modelFileInfo(modelFilePath);
+    return modelFileInfo.dir().filePath(modelFileInfo.completeBaseName() + ".fmm");
+}
+
+QString FrameShardStore::GetShardFilePath(int shardIndex) const {
+    return QFileInfo(_manifestPath).dir().filePath(_shards[shardIndex].fileName);
+}
+
+void FrameShardStore::LoadShard(int shardIndex) {
+    PROFILE_SCOPE("FrameShardStore::LoadShard");
+
+    QFile shardFile(GetShardFilePath(shardIndex));
+    FrameModelBatch batch;
+
+    if (shardFile.open(QFile::ReadOnly)) {
+        QTextStream shardIn(&shardFile);
+
+        while (!shardIn.atEnd()) {
+            FrameModelFile::ParseLine(shardIn.readLine(), batch);
+        }
+    }
+
+    // Пока шард загружается, добавленные фреймы относятся к нему, а изменения не делают его изменённым
+    _loadingShardIndex = shardIndex;
+    _shards[shardIndex].isLoaded = true;
+
+    for (const auto& frameRecord : qAsConst(batch.frameRecords)) {
+        _frameModel->AddFrame(Frame(frameRecord.name), frameRecord.position);
+    }
+
+    for (const auto& slotRecord : qAsConst(batch.slotRecords)) {
+        // Ссылка на фрейм, которого нет ни в модели, ни в индексе (удалённый, пока шард был выгружен), отбрасывается
+        const bool isSlotDangling = !_frameModel->IsLoaded(slotRecord.targetFrameName) ||
+                                    (slotRecord.isFrameReference && !_frameModel->IsLoaded(slotRecord.slotName) && !_frameShards.contains(slotRecord.slotName));
+
+        if (isSlotDangling)
+            _shards[shardIndex].isDirty = true;
+        else if (slotRecord.isFrameReference)
+            _frameModel->AddFrameReference(slotRecord.targetFrameName, slotRecord.slotName);
+        else
+            _frameModel->AddSlot(slotRecord.targetFrameName, _frameModel->Intern(slotRecord.slotName), _frameModel->Intern(slotRecord.slotValue));
+    }
+
+    _loadingShardIndex = -1;
+
+    auto& shard = _shards[shardIndex];
+
+    for (const auto frameHandle : qAsConst(shard.frameHandles)) {
+        shard.bytes += _frameModel->GetFrameBytes(frameHandle);
+    }
+
+    _loadedBytes += shard.bytes;
+    // Если при загрузке были отброшены слоты, содержимое шарда уже отличается от файла
+    shard.savedDigest = shard.isDirty ? std::nullopt : std::optional<quint64>(GetShardDigest(shardIndex));
+
+    PROFILE_COUNTER("FrameShardStore: память загруженных шардов, байт", _loadedBytes);
+}
+
+void FrameShardStore::UnloadShard(int shardIndex) {
+    PROFILE_SCOPE("FrameShardStore::UnloadShard");
+
+    auto& shard = _shards[shardIndex];
+
+    // Если изменённый шард не удалось записать, он остаётся в памяти, чтобы изменения не потерялись
+    if (shard.isDirty && !WriteShard(shardIndex))
+        return;
+
+    _isUnloading = true;
+    _frameModel->UnloadFrames(shard.frameHandles);
+    _isUnloading = false;
+
+    for (const auto frameHandle : qAsConst(shard.frameHandles)) {
+        _loadedFrames.remove(frameHandle);
+    }
+
+    shard.frameHandles.clear();
+    shard.frameHandles.squeeze();
+    shard.isLoaded = false;
+    _loadedBytes -= shard.bytes;
+    shard.bytes = 0;
+
+    PROFILE_COUNTER("FrameShardStore: память загруженных шардов, байт", _loadedBytes);
+}
+
+bool FrameShardStore::WriteShard(int shardIndex) {
+    auto& shard = _shards[shardIndex];
+    const auto shardDigest = GetShardDigest(shardIndex);
+
+    // Изменения, в итоге вернувшие шард к записанному состоянию, не требуют перезаписи файла
+    if (shard.savedDigest != shardDigest) {
+        if (!WriteShardFile(GetShardFilePath(shardIndex), *_frameModel, shard.frameHandles, shard.bounds))
+            return false;
+
+        shard.savedDigest = shardDigest;
+    }
+
+    shard.isDirty = false;
+    return true;
+}
+
+quint64 FrameShardStore::GetShardDigest(int shardIndex) const {
+    // Как и дайджест корзины модели, сумма дайджестов фреймов не зависит от их порядка в шарде
+    quint64 shardDigest = 0;
+
+    for (const auto frameHandle : _shards[shardIndex].frameHandles) {
+        if (const auto* frame = _frameModel->Get(frameHandle))
+            shardDigest += _frameModel->GetFrameDigest(frame->GetName());
+    }
+
+    return shardDigest;
+}
+
+void FrameShardStore::TouchShard(int shardIndex) {
+    _shards[shardIndex].lastUsedTick = ++_tick;
+}
+
+void FrameShardStore::ScheduleEviction() {
+    if (_isEvictionScheduled)
+        return;
+
+    // Выгрузка откладывается до возврата в цикл событий: вызывающий код может держать ссылки на фреймы выгружаемых шардов
+    _isEvictionScheduled = true;
+
+    QMetaObject::invokeMethod(this, [this]() {
+        _isEvictionScheduled = false;
+        EnforceMemoryBudget();
+    }, Qt::QueuedConnection);
+}
+
+void FrameShardStore::EnforceMemoryBudget(int pinnedShardIndex) {
+    while (_loadedBytes > _memoryBudget) {
+        int leastRecentlyUsedShardIndex = -1;
+
+        for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+            const auto& shard = _shards[shardIndex];
+
+            if (shard.isLoaded && shardIndex != pinnedShardIndex &&
+                (leastRecentlyUsedShardIndex < 0 || shard.lastUsedTick < _shards[leastRecentlyUsedShardIndex].lastUsedTick))
+                leastRecentlyUsedShardIndex = shardIndex;
+        }
+
+        if (leastRecentlyUsedShardIndex < 0)
+            return;
+
+        UnloadShard(leastRecentlyUsedShardIndex);
+
+        if (_shards[leastRecentlyUsedShardIndex].isLoaded)
+            return;
+    }
+}
+
+int FrameShardStore::ChooseShardFor(QPoint framePosition) {
+    int chosenShardIndex = -1;
+
+    // Новый фрейм попадает в загруженный шард, в границах которого он находится, иначе — в последний использованный
+    for (int shardIndex = 0; shardIndex < _shards.size(); ++shardIndex) {
+        const auto& shard = _shards[shardIndex];
+
+        if (!shard.isLoaded)
+            continue;
+
+        if (shard.bounds.contains(framePosition))
+            return shardIndex;
+
+        if (chosenShardIndex < 0 || shard.lastUsedTick > _shards[chosenShardIndex].lastUsedTick)
+            chosenShardIndex = shardIndex;
+    }
+
+    if (chosenShardIndex >= 0)
+        return chosenShardIndex;
+
+    Shard shard;
+    shard.fileName = GetShardFileName(_manifestPath, _shards.size());
+    shard.isLoaded = true;
+    _shards.append(shard);
+
+    return _shards.size() - 1;
+}
+
+void FrameShardStore::OnFrameAdded(FrameHandle frameHandle) {
+    const auto& frameName = _frameModel->Get(frameHandle)->GetName();
+    const auto framePosition = _frameModel->GetPosition(frameHandle);
+    const int shardIndex = _loadingShardIndex >= 0 ? _loadingShardIndex : ChooseShardFor(framePosition);
+    auto& shard = _shards[shardIndex];
+
+    shard.frameHandles.append(frameHandle);
+    _loadedFrames.insert(frameHandle, {shardIndex, frameName});
+    _frameShards.insert(frameName, shardIndex);
+
+    if (_loadingShardIndex < 0) {
+        shard.bounds |= QRect(framePosition, QSize(1, 1));
+        shard.isDirty = true;
+        TouchShard(shardIndex);
+    }
+}
+
+void FrameShardStore::OnFrameAboutToBeErased(FrameHandle frameHandle) {
+    // Выгрузка шарда сообщает о себе не этим сигналом, а FramesAboutToBeUnloaded, поэтому фрейм действительно удаляется
+    const auto loadedFrameIt = _loadedFrames.find(frameHandle);
+
+    if (loadedFrameIt == _loadedFrames.end())
+        return;
+
+    auto& shard = _shards[loadedFrameIt->shardIndex];
+    shard.frameHandles.removeOne(frameHandle);
+    shard.isDirty = true;
+
+    _frameShards.remove(loadedFrameIt->name);
+    _loadedFrames.erase(loadedFrameIt);
+}
+
+void FrameShardStore::OnFrameRenamed(FrameHandle frameHandle) {
+    const auto loadedFrameIt = _loadedFrames.find(frameHandle);
+
+    if (loadedFrameIt == _loadedFrames.end())
+        return;
+
+    _frameShards.remove(loadedFrameIt->name);
+    loadedFrameIt->name = _frameModel->Get(frameHandle)->GetName();
+    _frameShards.insert(loadedFrameIt->name, loadedFrameIt->shardIndex);
+    _shards[loadedFrameIt->shardIndex].isDirty = true;
+}
+
+void FrameShardStore::OnFrameChanged(FrameHandle frameHandle) {
+    // Разрешение и сброс ссылок при загрузке и выгрузке шардов не меняет их содержимого на диске
+    if (_loadingShardIndex >= 0 || _isUnloading)
+        return;
+
+    const auto loadedFrameIt = _loadedFrames.constFind(frameHandle);
+
+    if (loadedFrameIt == _loadedFrames.constEnd())
+        return;
+
+    auto& shard = _shards[loadedFrameIt->shardIndex];
+    shard.bounds |= QRect(_frameModel->GetPosition(frameHandle), QSize(1, 1));
+    shard.isDirty = true;
+}
+
+QString FrameShardStore::GetIndexPath(const QString& manifestPath) {
+    const QFileInfo manifestFileInfo(manifestPath);
+    return manifestFileInfo.dir().filePath(manifestFileInfo.completeBaseName() + ".fmi");
+}
+
+QString FrameShardStore::GetShardFileName(const QString& manifestPath, int shardIndex) {
+    return QString("%1_%2.fm").arg(QFileInfo(manifestPath).completeBaseName()).arg(shardIndex);
+}
+
+bool FrameShardStore::WriteShardFile(const QString& filePath, const FrameModel& frameModel, QVector<FrameHandle> frameHandles, QRect& bounds) {
+    QFile file(filePath);
+
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QTextStream out(&file);
+    bounds = QRect();
+
+    // Фреймы, которых уже нет в пуле, пропускаются
+    frameHandles.erase(std::remove_if(frameHandles.begin(), frameHandles.end(), [&](FrameHandle frameHandle) {
+        return !frameModel.Get(frameHandle);
+    }), frameHandles.end());
+
+    FrameModelFile::SortByFrameName(frameHandles, frameModel);
+
+    // Как и в файле целой модели, сначала все фреймы шарда по именам, затем их слоты
+    for (const auto frameHandle : qAsConst(frameHandles)) {
+        const auto framePosition = frameModel.GetPosition(frameHandle);
+
+        FrameModelFile::WriteFrame(out, *frameModel.Get(frameHandle), framePosition);
+        bounds |= QRect(framePosition, QSize(1, 1));
+    }
+
+    for (const auto frameHandle : qAsConst(frameHandles)) {
+        FrameModelFile::WriteSlots(out, *frameModel.Get(frameHandle));
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool FrameShardStore::WriteManifest(const QString& manifestPath, const QVector<Shard>& shards) {
+    QFile file(manifestPath);
+
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QTextStream out(&file);
+
+    for (const auto& shard : shards) {
+        out << QString::fromUtf8("Шард ") << shard.fileName << ' ' << shard.bounds.x() << ' ' << shard.bounds.y() << ' ' <<
+               shard.bounds.width() << ' ' << shard.bounds.height() << '\n';
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool FrameShardStore::WriteIndex(const QString& indexPath, const QHash<QString, int>& frameShards) {
+    QFile file(indexPath);
+
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    QTextStream out(&file);
+
+    for (auto frameShardIt = frameShards.cbegin(); frameShardIt != frameShards.cend(); ++frameShardIt) {
+        out << QString::fromUtf8("Фрейм ") << QString(frameShardIt.key()).replace(' ', '_') << ' ' << frameShardIt.value() << '\n';
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
@@ -0,0 +1,86 @@
+#ifndef FRAMESHARDSTORE_H
+#define FRAMESHARDSTORE_H
+
+#include "framemodel.h"
+#include <QObject>
+#include <optional>
+
+// Модель, разбитая на несколько файлов-шардов (.fm) с небольшим манифестом (.fmm) со списком шардов
+// и границами их фреймов и индексом [FrameName, ShardIndex] (.fmi). Шард загружается в FrameModel
+// целиком, когда нужен один из его фреймов: при поиске по имени, попадании в видимую область холста
+// или обходе всей модели. Если загруженные шарды превышают бюджет памяти, давно не использовавшиеся
+// выгружаются (изменённые перед этим записываются на диск). Ссылки между шардами хранятся по имени
+// и разрешаются моделью, когда загружается фрейм, на который они указывают
+class FrameShardStore : public QObject, public FrameSource {
+    Q_OBJECT
+
+public:
+    explicit FrameShardStore(FrameModel* frameModel, QObject* parent = nullptr);
+    bool Open(const QString& manifestPath);
+    bool IsOpen() const;
+    bool Save();
+    void SetMemoryBudget(qint64 memoryBudget);
+    int GetShardsCount() const;
+    int GetFramesCount() const;
+
+    bool LoadFrame(const QString& frameName) override;
+    void LoadArea(const QRect& area) override;
+    void ForEachPart(const std::function<void(const QVector<FrameHandle>&)>& visitor) override;
+    QStringList GetFrameNames() const override;
+
+    // Разбивает полностью загруженную модель на шарды, группируя соседние на холсте фреймы
+    static bool Write(const FrameModel& frameModel, const QString& manifestPath, int framesPerShard);
+    static QString GetManifestPath(const QString& modelFilePath);
+
+private:
+    struct Shard {
+        QString fileName; // Относительно каталога манифеста
+        QRect bounds; // Ограничивающий прямоугольник позиций фреймов
+        QVector<FrameHandle> frameHandles; // Пуст, пока шард не загружен
+        qint64 bytes = 0;
+        quint64 lastUsedTick = 0;
+        bool isLoaded = false, isDirty = false;
+        std::optional<quint64> savedDigest; // Сумма дайджестов фреймов, записанных в файл шарда
+    };
+
+    struct LoadedFrame {
+        int shardIndex;
+        QString name;
+    };
+
+    FrameModel* _frameModel;
+    QString _manifestPath;
+    QVector<Shard> _shards;
+    QHash<QString, int> _frameShards; // [FrameName, ShardIndex]
+    QHash<FrameHandle, LoadedFrame> _loadedFrames;
+    qint64 _memoryBudget = _defaultMemoryBudget, _loadedBytes = 0;
+    quint64 _tick = 0;
+    int _loadingShardIndex = -1;
+    bool _isUnloading = false, _isEvictionScheduled = false;
+
+    inline static constexpr qint64 _defaultMemoryBudget = 256ll * 1024 * 1024;
+    inline static constexpr int _tileSize = 1024; // Сторона квадрата холста, фреймы которого попадают в один шард
+    // Фрейм рисуется вправо и вниз от своей позиции, поэтому область поиска шардов расширяется влево и вверх
+    inline static constexpr int _frameExtentMargin = 512;
+
+    QString GetShardFilePath(int shardIndex) const;
+    void LoadShard(int shardIndex);
+    void UnloadShard(int shardIndex);
+    bool WriteShard(int shardIndex);
+    quint64 GetShardDigest(int shardIndex) const;
+    void TouchShard(int shardIndex);
+    void ScheduleEviction();
+    void EnforceMemoryBudget(int pinnedShardIndex = -1);
+    int ChooseShardFor(QPoint framePosition);
+    void OnFrameAdded(FrameHandle frameHandle);
+    void OnFrameAboutToBeErased(FrameHandle frameHandle);
+    void OnFrameRenamed(FrameHandle frameHandle);
+    void OnFrameChanged(FrameHandle frameHandle);
+    static QString GetIndexPath(const QString& manifestPath);
+    static QString GetShardFileName(const QString& manifestPath, int shardIndex);
+    static bool WriteShardFile(const QString& filePath, const FrameModel& frameModel, QVector<FrameHandle> frameHandles, QRect& bounds);
+    static bool WriteManifest(const QString& manifestPath, const QVector<Shard>& shards);
+    static bool WriteIndex(const QString& indexPath, const QHash<QString, int>& frameShards);
+};
+
+#endif // FRAMESHARDSTORE_H
@@ -0,0 +1,26 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include "framehandle.h"
+#include <QRect>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+// Источник фреймов, которые хранятся вне модели и подгружаются в неё по требованию
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Подгружает фрейм с именем frameName. Возвращает false, если такого фрейма в источнике нет или он уже загружен
+    virtual bool LoadFrame(const QString& frameName) = 0;
+    // Подгружает фреймы, которые могут быть видны в области area холста
+    virtual void LoadArea(const QRect& area) = 0;
+    // Поочерёдно подгружает все части источника и передаёт в visitor фреймы каждой из них. Между вызовами
+    // visitor ранее пройденные части могут быть выгружены, поэтому FrameHandle между ними не сохраняются
+    virtual void ForEachPart(const std::function<void(const QVector<FrameHandle>&)>& visitor) = 0;
+    // Имена всех фреймов источника, в том числе не загруженных, без чтения их частей
+    virtual QStringList GetFrameNames() const = 0;
+};
+
+#endif // FRAMESOURCE_H
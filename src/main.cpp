@@ -1,10 +1,17 @@
+#include "framemodeltool.h"
 #include "mainwindow.h"
 #include <QApplication>
 #include <QTextCodec>
 
 int main(int argc, char *argv[]) {
-    QApplication a(argc, argv);
     QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+
+    if (FrameModelTool::IsToolCommand(argc, argv)) {
+        QCoreApplication a(argc, argv);
+        return FrameModelTool::Run(a.arguments());
+    }
+
+    QApplication a(argc, argv);
     MainWindow w;
     w.show();
     return a.exec();
@@ -1,15 +1,26 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "framemodelimporter.h"
+#include "profiler.h"
+#include "profilerwidget.h"
+#include <QAction>
+#include <QDockWidget>
+#include <QFileDialog>
+#include <QMenuBar>
 #include <QMessageBox>
+#include <QStatusBar>
 #include <QFile>
+#include <QLocale>
 #include <QTextStream>
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow), _framePositionValidator(QRegularExpression("\\d{4}")),
     _groupBoxEnabledTitle("QGroupBox::title { color: black; }"), _groupBoxDisabledTitle("QGroupBox::title { color: gray; }"),
-    _filePath(QString(PROJECT_PATH).append("/resource/frame_model.fm"))
+    _filePath(QString(PROJECT_PATH).append("/resource/frame_model.fm")), _frameShardStore(&_frameModel), _frameModelHistory(&_frameModel)
 {
     ui->setupUi(this);
     Init();
+
+    // Модель загружается в фоне, поэтому окно появляется сразу, а фреймы дорисовываются по мере загрузки
     LoadFromFile();
 }
 
@@ -20,10 +31,34 @@ void MainWindow::Init() {
     ui->yNewFrame->setValidator(&_framePositionValidator);
     ui->slotTypeGroupBox->setStyleSheet(_groupBoxDisabledTitle);
 
+    ui->frameModel->SetModel(&_frameModel);
+    _slotFramesModel.SetModel(&_frameModel);
+    _targetFramesModel.SetModel(&_frameModel);
+    _framesToEditModel.SetModel(&_frameModel);
+
     ui->slotFrames->setModel(&_slotFramesModel);
     ui->targetFrames->setModel(&_targetFramesModel);
     ui->framesToEdit->setModel(&_framesToEditModel);
 
+    auto* profilerDock = new QDockWidget("Профилирование", this);
+    profilerDock->setObjectName("profilerDock");
+    profilerDock->setWidget(new ProfilerWidget(profilerDock));
+    addDockWidget(Qt::BottomDockWidgetArea, profilerDock);
+    profilerDock->setVisible(Profiler::Instance().IsEnabled());
+
+    auto* fileMenu = menuBar()->addMenu("Файл");
+    fileMenu->addAction("Импорт таблицы...", this, &MainWindow::ImportTable);
+    fileMenu->addAction("Разбить модель на шарды", this, &MainWindow::SplitIntoShards);
+
+    auto* editMenu = menuBar()->addMenu("Правка");
+    _undoAction = editMenu->addAction("Отменить", this, &MainWindow::UndoEdit, QKeySequence::Undo);
+    _redoAction = editMenu->addAction("Повторить", this, &MainWindow::RedoEdit, QKeySequence::Redo);
+    UpdateHistoryActions();
+
+    auto* viewMenu = menuBar()->addMenu("Вид");
+    viewMenu->addAction(profilerDock->toggleViewAction());
+    viewMenu->addAction("Память модели", this, &MainWindow::ShowMemoryReport);
+
     for (auto slotTypeButton : {ui->slotRegularType, ui->slotFrameType}) {
         connect(slotTypeButton, &QRadioButton::clicked, this, [=]() {
             const auto isSlotRegular = slotTypeButton == ui->slotRegularType;
@@ -43,6 +78,22 @@ void MainWindow::Init() {
         UpdateEditableSlotsOfFrame(editableFrameName);
     });
 
+    connect(&_frameModelLoader, &FrameModelLoader::BatchLoaded, this, &MainWindow::ApplyLoadedBatch);
+    connect(&_frameModelLoader, &FrameModelLoader::Finished, this, &MainWindow::FinishLoading);
+
+    connect(&_frameModelHistory, &FrameModelHistory::Changed, this, &MainWindow::UpdateHistoryActions);
+
+    // Все перемещения фреймов за одно перетаскивание отменяются вместе
+    connect(ui->frameModel, &FrameModelWidget::DragStarted, this, [=]() {
+        _frameModelHistory.BeginStep("Перемещение фреймов");
+    });
+
+    connect(ui->frameModel, &FrameModelWidget::DragFinished, &_frameModelHistory, &FrameModelHistory::EndStep);
+
+    connect(ui->frameModel, &FrameModelWidget::FrameSelected, this, [=](const QString& selectedFrameName) {
+        ui->framesToEdit->setCurrentText(selectedFrameName);
+    });
+
     connect(ui->editableSlotsOfEditableFrame, &QComboBox::currentTextChanged, this, [=](const QString& editableSlotName) {
         ui->editableSlotType->clear();
         ui->needsToChangedSlotValue->setChecked(false);
@@ -50,9 +101,9 @@ void MainWindow::Init() {
         ui->newValueOfRegularSlot->clear();
 
         if (!editableSlotName.isEmpty()) {
-            const auto& editableFrameSlots = ui->frameModel->At(ui->framesToEdit->currentText()).GetSlots();
+            const auto& editableFrameSlots = _frameModel.At(ui->framesToEdit->currentText()).GetSlots();
 
-            if (std::holds_alternative<QString>(editableFrameSlots.at(editableSlotName))) {
+            if (std::holds_alternative<QString>(editableFrameSlots.At(editableSlotName))) {
                 ui->editableSlotType->setText("Обычный слот");
                 ui->slotEditInfoGroupBox->setEnabled(true);
             }
@@ -65,6 +116,8 @@ void MainWindow::Init() {
 }
 
 void MainWindow::on_addFrame_clicked() {
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Добавление фрейма");
+
     const auto frameName = ui->frameName->text();
     const auto xFrame = ui->xFrame->text();
     const auto yFrame = ui->yFrame->text();
@@ -74,7 +127,7 @@ void MainWindow::on_addFrame_clicked() {
         return;
     }
 
-    if (ui->frameModel->Contains(frameName)) {
+    if (_frameModel.Contains(frameName)) {
         QMessageBox::critical(nullptr, "Ошибка при добавлении фрейма", "Фрейм \"" + frameName + "\" уже существует");
         return;
     }
@@ -82,24 +135,17 @@ void MainWindow::on_addFrame_clicked() {
     Frame frame(frameName);
     QPoint framePosition(QPoint(xFrame.toInt(), yFrame.toInt()));
 
-    const auto* addedFrame = ui->frameModel->AddFrame(std::move(frame), framePosition);
-    ui->frameModel->update();
-
-    _slotFramesModel.AddFrame(addedFrame);
-    _targetFramesModel.AddFrame(addedFrame);
-    _framesToEditModel.AddFrame(addedFrame);
-
-    ui->addSlotGroupBox->setEnabled(true);
-    ui->editFrameGroupBox->setEnabled(true);
-    ui->slotTypeGroupBox->setEnabled(true);
-    ui->slotTypeGroupBox->setStyleSheet(_groupBoxEnabledTitle);
+    // Холст и списки фреймов обновятся сами по сигналу FrameModel::FrameAdded
+    _frameModel.AddFrame(std::move(frame), framePosition);
+    SetEditingEnabled(true);
 
     ResetFrameInfo();
 }
 
 void MainWindow::on_addSlot_clicked() {
-    auto& frameModel = *ui->frameModel;
-    auto& targetFrame = frameModel.At(ui->targetFrames->currentText());
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Добавление слота");
+
+    const auto& targetFrame = _frameModel.At(ui->targetFrames->currentText());
 
     if (ui->slotRegularType->isChecked()) {
         const auto slotName = ui->slotName->text();
@@ -121,10 +167,10 @@ void MainWindow::on_addSlot_clicked() {
             return;
         }
 
-        targetFrame.AddSlot(std::move(slotName), slotValue.isEmpty() ? "Значение" : std::move(slotValue));
+        _frameModel.AddSlot(targetFrame.GetName(), _frameModel.Intern(slotName), _frameModel.Intern(slotValue.isEmpty() ? "Значение" : slotValue));
     }
     else {
-        const auto& slotFrame = frameModel.At(ui->slotFrames->currentText());
+        const auto& slotFrame = _frameModel.At(ui->slotFrames->currentText());
 
         if (targetFrame.GetName() == slotFrame.GetName()) {
             QMessageBox::critical(nullptr, "Ошибка при добавлении слота-фрейма", "Фрейм не может содержать одноимённый слот");
@@ -137,30 +183,31 @@ void MainWindow::on_addSlot_clicked() {
             return;
         }
 
-        targetFrame.AddSlot(&slotFrame);
+        _frameModel.AddFrameSlot(targetFrame.GetName(), slotFrame.GetName());
     }
 
     if (targetFrame.GetName() == ui->framesToEdit->currentText()) {
         UpdateEditableSlotsOfFrame(targetFrame.GetName());
     }
 
-    ui->frameModel->update();
     ResetSlotInfo();
 }
 
 void MainWindow::on_editFrame_clicked() {
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Редактирование фрейма");
+
     auto newFrameName = ui->newFrameName->text();
-    ui->frameModel->ReplaceFrameCoords(ui->framesToEdit->currentText(), ui->xNewFrame->text(), ui->yNewFrame->text());
+    _frameModel.ReplaceFrameCoords(ui->framesToEdit->currentText(), ui->xNewFrame->text(), ui->yNewFrame->text());
     ui->xNewFrame->clear();
     ui->yNewFrame->clear();
 
     if (!newFrameName.isEmpty()) {
-        if (ui->frameModel->Contains(newFrameName)) {
+        if (_frameModel.Contains(newFrameName)) {
             QMessageBox::critical(nullptr, "Ошибка при редактировании фрейма", "Фрейм \"" + newFrameName + "\" уже существует");
             return;
         }
 
-        auto& frame = ui->frameModel->At(ui->framesToEdit->currentText());
+        const auto& frame = _frameModel.At(ui->framesToEdit->currentText());
 
         if (frame.Contains(newFrameName)) {
             QMessageBox::critical(nullptr, "Ошибка при редактировании фрейма",
@@ -168,37 +215,37 @@ void MainWindow::on_editFrame_clicked() {
             return;
         }
 
-        ui->frameModel->ReplaceFrameName(ui->framesToEdit->currentText(), std::move(newFrameName));
-        ui->slotFrames->update();
-        ui->targetFrames->update();
-        ui->framesToEdit->update();
+        // Ссылающиеся фреймы получат слот-фрейм с новым именем, поэтому обычного слота с таким именем у них быть не должно
+        // (обход модели может выгрузить шард, поэтому ссылка frame дальше не используется)
+        const auto conflictingFrameName = _frameModel.FindFrameRenameConflict(ui->framesToEdit->currentText(), newFrameName);
+
+        if (!conflictingFrameName.isEmpty()) {
+            QMessageBox::critical(nullptr, "Ошибка при редактировании фрейма",
+                                  "Во фрейме \"" + conflictingFrameName + "\", ссылающемся на \"" + ui->framesToEdit->currentText() +
+                                  "\", уже содержится слот с именем \"" + newFrameName + "\"");
+            return;
+        }
+
+        // Списки фреймов и холст обновятся сами по сигналу FrameModel::FrameRenamed
+        _frameModel.ReplaceFrameName(ui->framesToEdit->currentText(), std::move(newFrameName));
         ui->newFrameName->clear();
     }
-
-    ui->frameModel->update();
 }
 
 void MainWindow::on_deleteFrame_clicked() {
-    const auto currentEditableFrameName = ui->framesToEdit->currentText();
-    const auto& frame = ui->frameModel->At(currentEditableFrameName);
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Удаление фрейма");
 
-    ui->frameModel->EraseFrame(currentEditableFrameName);
-    ui->frameModel->update();
+    // Списки фреймов убирают удаляемый фрейм сами по сигналу FrameModel::FrameAboutToBeErased
+    _frameModel.EraseFrame(ui->framesToEdit->currentText());
     ui->newFrameName->clear();
 
-    _slotFramesModel.EraseFrame(&frame);
-    _targetFramesModel.EraseFrame(&frame);
-    _framesToEditModel.EraseFrame(&frame);
-
-    if (ui->frameModel->IsEmpty()) {
-        ui->addSlotGroupBox->setEnabled(false);
-        ui->editFrameGroupBox->setEnabled(false);
-        ui->slotTypeGroupBox->setEnabled(false);
-        ui->slotTypeGroupBox->setStyleSheet(_groupBoxDisabledTitle);
-    }
+    if (_frameModel.IsEmpty())
+        SetEditingEnabled(false);
 }
 
 void MainWindow::on_editSlot_clicked() {
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Редактирование слота");
+
     auto currentSlotName = ui->editableSlotsOfEditableFrame->currentText();
 
     // Если у редактируемого фрейма есть слоты (в таком случае в комбобоксе будет значение)
@@ -208,11 +255,11 @@ void MainWindow::on_editSlot_clicked() {
         ui->editableSlotsOfEditableFrame->blockSignals(true);
 
         auto newSlotName = ui->newSlotName->text();
-        auto& editableFrame = ui->frameModel->At(ui->framesToEdit->currentText());
+        const auto& editableFrame = _frameModel.At(ui->framesToEdit->currentText());
 
         // В принципе ReplaceSlotName и ReplaceSlotValue можно объединить в один метод
         if (!newSlotName.isEmpty()) {
-            if (ui->frameModel->Contains(newSlotName)) {
+            if (_frameModel.Contains(newSlotName)) {
                 QMessageBox::critical(nullptr, "Ошибка при редактировании слота", "Фрейм \"" + newSlotName + "\" уже существует");
                 return;
             }
@@ -223,33 +270,32 @@ void MainWindow::on_editSlot_clicked() {
                 return;
             }
 
-            editableFrame.ReplaceSlotName(currentSlotName, newSlotName);
+            _frameModel.ReplaceSlotName(editableFrame.GetName(), currentSlotName, newSlotName);
             currentSlotName = std::move(newSlotName);
             ui->editableSlotsOfEditableFrame->setItemText(ui->editableSlotsOfEditableFrame->currentIndex(), currentSlotName);
         }
 
         if (ui->needsToChangedSlotValue->isChecked()) {
             auto newSlotValue = ui->newValueOfRegularSlot->text();
-            editableFrame.ReplaceSlotValue(currentSlotName, newSlotValue.isEmpty() ? "Значение" : std::move(newSlotValue));
+            _frameModel.ReplaceSlotValue(editableFrame.GetName(), currentSlotName, newSlotValue.isEmpty() ? "Значение" : std::move(newSlotValue));
         }
 
         ui->needsToChangedSlotValue->setChecked(false);
         ui->newSlotName->clear();
         ui->newValueOfRegularSlot->clear();
-        ui->frameModel->update();
         ui->editableSlotsOfEditableFrame->blockSignals(false);
     }
 }
 
 void MainWindow::on_deleteSlot_clicked() {
+    const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Удаление слота");
+
     auto currentSlotName = ui->editableSlotsOfEditableFrame->currentText();
 
     // Если у редактируемого фрейма есть слоты (в таком случае в комбобоксе будет значение)
     if (!currentSlotName.isEmpty()) {
-        auto& editableFrame = ui->frameModel->At(ui->framesToEdit->currentText());
-        editableFrame.EraseSlot(currentSlotName);
+        _frameModel.EraseSlot(ui->framesToEdit->currentText(), currentSlotName);
         ui->editableSlotsOfEditableFrame->removeItem(ui->editableSlotsOfEditableFrame->currentIndex());
-        ui->frameModel->update();
     }
 }
 
@@ -262,7 +308,7 @@ void MainWindow::on_syntaxSearch_clicked() {
     }
 
     const auto syntaxSearchSlotNames = syntaxSearchSlotNamesText.split(';');
-    const auto syntaxSearchResult = ui->frameModel->SyntaxSearch(syntaxSearchSlotNames);
+    const auto syntaxSearchResult = _frameModel.SyntaxSearch(syntaxSearchSlotNames);
 
     QMessageBox::information(nullptr, "Результат синтаксического поиска", syntaxSearchResult);
 }
@@ -276,11 +322,137 @@ void MainWindow::on_semanticSearch_clicked() {
     }
 
     const auto semanticSearchSlotValues = semanticSearchSlotValuesText.split(';');
-    const auto semanticSearchResult = ui->frameModel->SemanticSearch(semanticSearchSlotValues);
+    const auto semanticSearchResult = _frameModel.SemanticSearch(semanticSearchSlotValues);
 
     QMessageBox::information(nullptr, "Результат семантического поиска", semanticSearchResult);
 }
 
+void MainWindow::on_substringSearch_clicked() {
+    const auto substring = ui->substringSearchText->text();
+
+    if (substring.isEmpty()) {
+        QMessageBox::critical(nullptr, "Ошибка поиска подстроки", "Введите часть имени или значения слота для поиска");
+        return;
+    }
+
+    const auto caseSensitivity = ui->substringSearchCaseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const auto substringSearchResult = _frameModel.SubstringSearch(substring, caseSensitivity);
+
+    QMessageBox::information(nullptr, "Результат поиска подстроки", substringSearchResult);
+}
+
+void MainWindow::ShowMemoryReport() {
+    auto report = _frameModel.GetMemoryReport();
+    report.indexBytes += ui->frameModel->GetIndexBytes();
+
+    PROFILE_COUNTER("Память модели: фреймы, байт", report.frameBytes);
+    PROFILE_COUNTER("Память модели: слоты, байт", report.slotBytes);
+    PROFILE_COUNTER("Память модели: строки, байт", report.stringBytes);
+    PROFILE_COUNTER("Память модели: индексы, байт", report.indexBytes);
+
+    auto formatBytes = [](qint64 bytes) {
+        return QLocale().formattedDataSize(bytes);
+    };
+
+    QMessageBox::information(nullptr, "Память модели",
+                             QString("Фреймов: %1, слотов: %2, уникальных строк: %3\n\n").arg(report.framesCount).arg(report.slotsCount).arg(report.stringsCount) +
+                             "Фреймы: " + formatBytes(report.frameBytes) + "\n" +
+                             "Слоты: " + formatBytes(report.slotBytes) + "\n" +
+                             "Строки: " + formatBytes(report.stringBytes) + "\n" +
+                             "Индексы: " + formatBytes(report.indexBytes) + "\n\n" +
+                             "Всего: " + formatBytes(report.GetTotalBytes()) + "\n\n" +
+                             QString("История правок: %1 шагов отмены, %2 шагов повтора, ").
+                             arg(_frameModelHistory.GetUndoDepth()).arg(_frameModelHistory.GetRedoDepth()) +
+                             formatBytes(_frameModelHistory.GetBytes()));
+}
+
+void MainWindow::UndoEdit() {
+    _frameModelHistory.Undo();
+    UpdateAfterHistoryStep();
+}
+
+void MainWindow::RedoEdit() {
+    _frameModelHistory.Redo();
+    UpdateAfterHistoryStep();
+}
+
+void MainWindow::UpdateAfterHistoryStep() {
+    // Отмена могла вернуть удалённый последний фрейм или убрать единственный добавленный
+    SetEditingEnabled(!_frameModel.IsEmpty() || _frameShardStore.GetFramesCount() > 0);
+    UpdateEditableSlotsOfFrame(ui->framesToEdit->currentText());
+}
+
+void MainWindow::UpdateHistoryActions() {
+    _undoAction->setEnabled(_frameModelHistory.CanUndo());
+    _undoAction->setText(_frameModelHistory.CanUndo() ? "Отменить: " + _frameModelHistory.GetUndoDescription() : "Отменить");
+    _redoAction->setEnabled(_frameModelHistory.CanRedo());
+    _redoAction->setText(_frameModelHistory.CanRedo() ? "Повторить: " + _frameModelHistory.GetRedoDescription() : "Повторить");
+}
+
+void MainWindow::SplitIntoShards() {
+    if (_frameShardStore.IsOpen()) {
+        QMessageBox::critical(nullptr, "Ошибка при разбиении модели на шарды", "Модель уже загружена из шардов");
+        return;
+    }
+
+    if (_frameModelLoader.IsLoading()) {
+        QMessageBox::critical(nullptr, "Ошибка при разбиении модели на шарды", "Модель ещё загружается");
+        return;
+    }
+
+    if (!FrameShardStore::Write(_frameModel, FrameShardStore::GetManifestPath(_filePath), _framesPerShard)) {
+        QMessageBox::critical(nullptr, "Ошибка при разбиении модели на шарды", "Не удалось записать шарды рядом с файлом \"" + _filePath + "\"");
+        return;
+    }
+
+    // До конца работы модель остаётся целиком в памяти, а при закрытии шарды перезаписываются вместе с файлом модели
+    _isSplitIntoShards = true;
+
+    QMessageBox::information(nullptr, "Разбиение модели на шарды",
+                             QString("Модель записана в %1 шардов. При следующем запуске она будет загружаться по частям").
+                             arg((_frameModel.Size() + _framesPerShard - 1) / _framesPerShard));
+}
+
+void MainWindow::ImportTable() {
+    // Импорт меняет модель пакетом в обход сигналов, по которым хранилище шардов следит за фреймами
+    if (_frameShardStore.IsOpen()) {
+        QMessageBox::critical(nullptr, "Ошибка при импорте таблицы", "Модель загружена из шардов");
+        return;
+    }
+
+    if (_frameModelLoader.IsLoading()) {
+        QMessageBox::critical(nullptr, "Ошибка при импорте таблицы", "Модель ещё загружается");
+        return;
+    }
+
+    const auto tableFilePath = QFileDialog::getOpenFileName(this, "Импорт таблицы", QString(), "Таблицы (*.csv *.tsv *.txt);;Все файлы (*)");
+
+    if (tableFilePath.isEmpty())
+        return;
+
+    FrameModelImport import;
+
+    // Весь импорт отменяется одним шагом
+    {
+        const FrameModelHistory::Scope historyScope(&_frameModelHistory, "Импорт таблицы");
+        import = FrameModelImporter::Import(tableFilePath, _frameModel);
+    }
+
+    if (!import.isFileOpened) {
+        QMessageBox::critical(nullptr, "Ошибка при импорте таблицы", "Не удалось открыть файл \"" + tableFilePath + "\"");
+        return;
+    }
+
+    SetEditingEnabled(!_frameModel.IsEmpty());
+    UpdateEditableSlotsOfFrame(ui->framesToEdit->currentText());
+
+    QMessageBox messageBox(import.isCommitted ? QMessageBox::Information : QMessageBox::Critical, "Импорт таблицы",
+                           QString("Импортировано строк: %1 из %2, новых фреймов: %3, слотов: %4, ошибок: %5").arg(import.importedRowsCount).
+                           arg(import.rowsCount).arg(import.framesCount).arg(import.slotsCount + import.referencesCount).arg(import.GetErrorsCount()));
+    messageBox.setDetailedText(import.ToText());
+    messageBox.exec();
+}
+
 void MainWindow::ResetFrameInfo() {
     ui->frameName->clear();
     ui->xFrame->clear();
@@ -298,95 +470,143 @@ void MainWindow::UpdateEditableSlotsOfFrame(const QString& editableFrameName) {
     ui->editableSlotsOfEditableFrame->clear();
 
     if (!editableFrameName.isEmpty()) {
-        for (const auto& [slotFrameName, _] : ui->frameModel->At(editableFrameName).GetSlots()) {
+        for (const auto& [slotFrameName, _] : _frameModel.At(editableFrameName).GetSlots()) {
             ui->editableSlotsOfEditableFrame->addItem(slotFrameName);
         }
     }
 }
 
-void MainWindow::LoadFromFile() {
-/* |  0  |    1   |  2 | 3 |    <--- Индексы в записи о фрейме
- *  Фрейм Водитель 1125 150     <--- Так хранится в файле запись о фрейме
- */
+void MainWindow::SetEditingEnabled(bool isEnabled) {
+    ui->addSlotGroupBox->setEnabled(isEnabled);
+    ui->editFrameGroupBox->setEnabled(isEnabled);
+    ui->slotTypeGroupBox->setEnabled(isEnabled);
+    ui->slotTypeGroupBox->setStyleSheet(isEnabled ? _groupBoxEnabledTitle : _groupBoxDisabledTitle);
+}
 
-/* |  0 |   1   |    2   |      3     |      4      |    5   |  <--- Индексы в записи о слоте
- *  Слот Человек Значение Фрейм-ссылка Целевой_Фрейм Водитель   <--- Так хранится в файле запись о слоте-фрейме
- *
- * |  0 |     1    |    2   |  3 |      4      |                     5                    |  <--- Индексы в записи о слоте
- *  Слот GPS-трекер Значение Есть Целевой_Фрейм Выделенная_для_перевозки_пассажиров_машина   <--- Так хранится в файле запись об обычном слоте
- */
+void MainWindow::SetLoadingState(bool isLoading) {
+    // Пока модель загружается, её нельзя ни изменять (в том числе перетаскиванием фреймов на холсте), ни искать по ней
+    ui->addFrameGroupBox->setEnabled(!isLoading);
+    ui->searchGroupBox->setEnabled(!isLoading);
+    ui->frameModel->setEnabled(!isLoading);
 
-    QFile file(_filePath);
+    if (isLoading) {
+        SetEditingEnabled(false);
+        statusBar()->showMessage("Загрузка модели...");
+    }
+    else {
+        statusBar()->clearMessage();
+    }
+}
 
-    if (file.open(QFile::ReadOnly)) {
-        QTextStream in(&file);
+void MainWindow::LoadFromFile() {
+    _loadStartNs = Profiler::Instance().NowNs();
 
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            QStringList splitLine = line.split(' ');
+    // Если рядом с файлом модели есть манифест шардов, фреймы подгружаются по частям по мере обращения к ним
+    if (_frameShardStore.Open(FrameShardStore::GetManifestPath(_filePath))) {
+        const auto memoryBudgetMb = qEnvironmentVariableIntValue("FRAMEMODEL_SHARD_BUDGET_MB");
 
-            if (splitLine[0] == "Фрейм") {
-                Frame frame(splitLine[1].replace('_', ' '));
-                const auto* addedFrame = ui->frameModel->AddFrame(std::move(frame), QPoint(splitLine[2].toInt(), splitLine[3].toInt()));
+        if (memoryBudgetMb > 0)
+            _frameShardStore.SetMemoryBudget(memoryBudgetMb * 1024ll * 1024);
 
-                _slotFramesModel.AddFrame(addedFrame);
-                _targetFramesModel.AddFrame(addedFrame);
-                _framesToEditModel.AddFrame(addedFrame);
-            }
-            else if (splitLine[0] == "Слот"){
-                if (splitLine[3] == "Фрейм-ссылка") {
-                    const auto& frameSlot = ui->frameModel->At(splitLine[1].replace('_', ' '));
-                    ui->frameModel->At(splitLine[5].replace('_', ' ')).AddSlot(&frameSlot);
-                }
-                else {
-                    ui->frameModel->At(splitLine[5].replace('_', ' ')).AddSlot(splitLine[1].replace('_', ' '), splitLine[3].replace('_', ' '));
-                }
-            }
-        }
+        _frameModel.SetFrameSource(&_frameShardStore);
+        FinishLoading();
+        return;
+    }
 
-        file.close();
+    SetLoadingState(true);
+    _frameModelLoader.Start(_filePath);
+}
 
-        if (!ui->frameModel->IsEmpty()) {
-            ui->addSlotGroupBox->setEnabled(true);
-            ui->editFrameGroupBox->setEnabled(true);
-            ui->slotTypeGroupBox->setEnabled(true);
-            ui->slotTypeGroupBox->setStyleSheet(_groupBoxEnabledTitle);
-            UpdateEditableSlotsOfFrame(ui->framesToEdit->currentText());
-        }
+void MainWindow::ApplyLoadedBatch(const FrameModelBatch& batch) {
+    PROFILE_SCOPE("MainWindow::ApplyLoadedBatch");
+
+    // Холст и списки фреймов обновляются по сигналам модели, поэтому каждая порция сразу видна
+    for (const auto& frameRecord : batch.frameRecords) {
+        _frameModel.AddFrame(Frame(frameRecord.name), frameRecord.position);
     }
+
+    for (const auto& slotRecord : batch.slotRecords) {
+        if (!ApplySlotRecord(slotRecord))
+            _pendingSlotRecords.append(slotRecord);
+    }
+
+    statusBar()->showMessage(QString("Загрузка модели: %1 фреймов").arg(_frameModel.Size()));
 }
 
-void MainWindow::SaveToFile() {
-    QFile file(_filePath);
-    file.open(QFile::WriteOnly);
-    QTextStream out(&file);
+bool MainWindow::ApplySlotRecord(const FrameModelBatch::SlotRecord& slotRecord) {
+    if (!_frameModel.Contains(slotRecord.targetFrameName))
+        return false;
 
-    // Сначала сохранение просто всех фреймов
-    for (const auto& [frameName, frameWithPosition] : ui->frameModel->GetFrames()) {
-        out << QString::fromUtf8("Фрейм ") << QString(frameName).replace(' ', '_') << " " <<
-               QString::number(frameWithPosition.second.x()) << ' ' << QString::number(frameWithPosition.second.y()) << '\n';
+    if (slotRecord.isFrameReference) {
+        if (!_frameModel.Contains(slotRecord.slotName))
+            return false;
+
+        _frameModel.AddFrameSlot(slotRecord.targetFrameName, slotRecord.slotName);
+    }
+    else {
+        _frameModel.AddSlot(slotRecord.targetFrameName, _frameModel.Intern(slotRecord.slotName), _frameModel.Intern(slotRecord.slotValue));
     }
 
-    // Сохранение всех слотов всех фреймов
-    for (const auto& [frameName, frameWithPosition] : ui->frameModel->GetFrames()) {
-        for (const auto& [slotName, frameSlot] : frameWithPosition.first.GetSlots()) {
-            QString slotValue;
+    return true;
+}
 
-            if (std::holds_alternative<QString>(frameSlot))
-                slotValue = QString(std::get<QString>(frameSlot)).replace(' ', '_');
-            else
-                slotValue = QString::fromUtf8("Фрейм-ссылка");
+void MainWindow::FinishLoading() {
+    PROFILE_SCOPE("MainWindow::FinishLoading");
 
-            out << QString::fromUtf8("Слот ") << QString(slotName).replace(' ', '_') <<
-                   QString::fromUtf8(" Значение ") << slotValue <<
-                   QString::fromUtf8(" Целевой_Фрейм ") << QString(frameName).replace(' ', '_') << '\n';
-        }
+    // Фреймы, на которые ссылаются отложенные слоты, к этому моменту уже загружены. Слоты, целевого фрейма
+    // или фрейма-ссылки которых в файле нет, пропускаются
+    for (const auto& slotRecord : qAsConst(_pendingSlotRecords)) {
+        ApplySlotRecord(slotRecord);
+    }
+
+    _pendingSlotRecords.clear();
+    _pendingSlotRecords.squeeze();
+    _savedDigest = _frameModel.GetDigest();
+    SetLoadingState(false);
+
+    if (!_frameModel.IsEmpty() || _frameShardStore.GetFramesCount() > 0) {
+        SetEditingEnabled(true);
+        UpdateEditableSlotsOfFrame(ui->framesToEdit->currentText());
     }
 
-    file.close();
+#ifndef FRAMEMODEL_NO_PROFILING
+    // Модель загружается в фоне, поэтому загрузка целиком, от открытия файла до применения отложенных слотов,
+    // не укладывается в одну область видимости и записывается отдельно
+    auto& profiler = Profiler::Instance();
+
+    if (profiler.IsEnabled())
+        profiler.RecordScope("MainWindow::LoadFromFile", _loadStartNs, profiler.NowNs() - _loadStartNs);
+#endif
+}
+
+void MainWindow::SaveToFile() {
+    PROFILE_SCOPE("MainWindow::SaveToFile");
+
+    // Если дайджест модели не изменился с загрузки или прошлого сохранения, файл переписывать незачем
+    if (_frameModel.GetDigest() == _savedDigest)
+        return;
+
+    // Дайджест запоминается только после успешной записи, иначе следующее сохранение было бы пропущено
+    if (FrameModelFile::Save(_filePath, _frameModel))
+        _savedDigest = _frameModel.GetDigest();
+    else
+        QMessageBox::critical(nullptr, "Ошибка при сохранении модели", "Не удалось записать файл \"" + _filePath + "\"");
 }
 
 MainWindow::~MainWindow() {
-    SaveToFile();
+    if (_frameShardStore.IsOpen()) {
+        _frameShardStore.Save();
+    }
+    // Если окно закрыто до окончания загрузки, модель не сохраняется, чтобы не затереть файл её частью
+    else if (_frameModelLoader.IsLoading()) {
+        _frameModelLoader.Cancel();
+    }
+    else {
+        SaveToFile();
+
+        if (_isSplitIntoShards)
+            FrameShardStore::Write(_frameModel, FrameShardStore::GetManifestPath(_filePath), _framesPerShard);
+    }
+
     delete ui;
 }
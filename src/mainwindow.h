@@ -2,6 +2,10 @@
 #define MAINWINDOW_H
 
 #include "framecomboboxmodel.h"
+#include "framemodel.h"
+#include "framemodelhistory.h"
+#include "framemodelloader.h"
+#include "frameshardstore.h"
 #include <QMainWindow>
 #include <QRegularExpressionValidator>
 
@@ -25,19 +29,46 @@ private slots:
     void on_deleteSlot_clicked();
     void on_syntaxSearch_clicked();
     void on_semanticSearch_clicked();
+    void on_substringSearch_clicked();
 
 private:
     Ui::MainWindow* ui;
     QRegularExpressionValidator _framePositionValidator;
     const QString _groupBoxEnabledTitle, _groupBoxDisabledTitle;
+    FrameModel _frameModel;
     FrameComboBoxModel _slotFramesModel, _targetFramesModel, _framesToEditModel;
     QString _filePath;
+    FrameModelLoader _frameModelLoader;
+    FrameShardStore _frameShardStore;
+    FrameModelHistory _frameModelHistory;
+    QAction* _undoAction = nullptr;
+    QAction* _redoAction = nullptr;
+    bool _isSplitIntoShards = false;
+    // Слоты, целевой фрейм (или фрейм-ссылка) которых ещё не загружен
+    QVector<FrameModelBatch::SlotRecord> _pendingSlotRecords;
+    quint64 _savedDigest = 0; // Дайджест модели в файле
+    qint64 _loadStartNs = 0; // Начало загрузки по часам Profiler
+
+    inline static constexpr int _framesPerShard = 4096;
 
     void Init();
     void ResetFrameInfo();
     void ResetSlotInfo();
     void UpdateEditableSlotsOfFrame(const QString& editableFrameName);
+
+    void ShowMemoryReport();
+    void UndoEdit();
+    void RedoEdit();
+    void UpdateAfterHistoryStep();
+    void UpdateHistoryActions();
+    void SplitIntoShards();
+    void ImportTable();
+    void SetEditingEnabled(bool isEnabled);
+    void SetLoadingState(bool isLoading);
     void LoadFromFile();
+    void ApplyLoadedBatch(const FrameModelBatch& batch);
+    bool ApplySlotRecord(const FrameModelBatch::SlotRecord& slotRecord);
+    void FinishLoading();
     void SaveToFile();
 };
 
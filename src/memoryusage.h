@@ -0,0 +1,27 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+// Оценки объёма памяти, занимаемого контейнерами Qt. Учитываются массив корзин и узлы
+// (указатель на следующий узел, хеш, ключ и значение), без служебных данных аллокатора
+namespace MemoryUsage {
+    template <typename Key, typename T>
+    qint64 GetHashBytes(const QHash<Key, T>& hash) {
+        return static_cast<qint64>(hash.capacity()) * sizeof(void*) + static_cast<qint64>(hash.size()) * (sizeof(void*) + sizeof(uint) + sizeof(Key) + sizeof(T));
+    }
+
+    template <typename T>
+    qint64 GetSetBytes(const QSet<T>& set) {
+        return static_cast<qint64>(set.capacity()) * sizeof(void*) + static_cast<qint64>(set.size()) * (sizeof(void*) + sizeof(uint) + sizeof(T));
+    }
+
+    // Размер буфера строки вместе с заголовком QArrayData (сам объект QString учитывается там, где он хранится)
+    inline qint64 GetStringDataBytes(const QString& string) {
+        return string.isEmpty() ? 0 : sizeof(QArrayData) + static_cast<qint64>(string.capacity() + 1) * sizeof(QChar);
+    }
+}
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,168 @@
+#include "profiler.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+Profiler::Profiler() {
+    _clock.start();
+    // Включение через переменную окружения позволяет захватить и загрузку модели при старте
+    _isEnabled.store(qEnvironmentVariableIntValue("FRAMEMODEL_PROFILE") != 0, std::memory_order_relaxed);
+}
+
+Profiler& Profiler::Instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::SetEnabled(bool isEnabled) {
+    _isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+qint64 Profiler::NowNs() const {
+    return _clock.nsecsElapsed();
+}
+
+void Profiler::RecordScope(const char* name, qint64 startNs, qint64 durationNs) {
+    QMutexLocker locker(&_mutex);
+    name = CanonicalName(name);
+    auto& timer = _timers[name];
+
+    ++timer.count;
+    timer.lastNs = durationNs;
+    timer.totalNs += durationNs;
+
+    if (timer.recentNs.size() < _recentSamplesCount) {
+        timer.recentNs.append(durationNs);
+    }
+    else {
+        timer.recentNs[timer.nextRecent] = durationNs;
+        timer.nextRecent = (timer.nextRecent + 1) % _recentSamplesCount;
+    }
+
+    AppendTraceEvent({name, 'X', startNs, durationNs, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+
+void Profiler::RecordCounter(const char* name, qint64 value) {
+    const auto nowNs = NowNs();
+    QMutexLocker locker(&_mutex);
+    name = CanonicalName(name);
+    auto& counter = _counters[name];
+
+    ++counter.count;
+    counter.value = value;
+    AppendTraceEvent({name, 'C', nowNs, value, reinterpret_cast<quintptr>(QThread::currentThreadId())});
+}
+
+QVector<Profiler::TimerStats> Profiler::GetTimerStats() const {
+    QMutexLocker locker(&_mutex);
+    QVector<TimerStats> result;
+    result.reserve(_timers.size());
+
+    for (auto timerIt = _timers.cbegin(); timerIt != _timers.cend(); ++timerIt) {
+        const auto& timer = timerIt.value();
+        auto recentNs = timer.recentNs;
+
+        auto percentileMs = [&recentNs](double percentile) -> double {
+            if (recentNs.isEmpty())
+                return 0;
+
+            const auto nthIt = recentNs.begin() + static_cast<int>(percentile * (recentNs.size() - 1));
+            std::nth_element(recentNs.begin(), nthIt, recentNs.end());
+            return *nthIt / 1e6;
+        };
+
+        result.append({timerIt.key(), timer.count, timer.lastNs / 1e6, percentileMs(0.5), percentileMs(0.99), timer.totalNs / 1e6});
+    }
+
+    std::sort(result.begin(), result.end(), [](const TimerStats& left, const TimerStats& right) {
+        return qstrcmp(left.name, right.name) < 0;
+    });
+
+    return result;
+}
+
+QVector<Profiler::CounterStats> Profiler::GetCounterStats() const {
+    QMutexLocker locker(&_mutex);
+    QVector<CounterStats> result;
+    result.reserve(_counters.size());
+
+    for (auto counterIt = _counters.cbegin(); counterIt != _counters.cend(); ++counterIt) {
+        result.append({counterIt.key(), counterIt.value().count, counterIt.value().value});
+    }
+
+    std::sort(result.begin(), result.end(), [](const CounterStats& left, const CounterStats& right) {
+        return qstrcmp(left.name, right.name) < 0;
+    });
+
+    return result;
+}
+
+bool Profiler::SaveChromeTrace(const QString& filePath) const {
+    QFile file(filePath);
+
+    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+
+    QMutexLocker locker(&_mutex);
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+
+    auto escapedName = [](const char* name) {
+        return QString::fromUtf8(name).replace('\\', "\\\\").replace('"', "\\\"");
+    };
+
+    // Время в формате trace-event задаётся в микросекундах
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << _droppedTraceEvents << "},\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << QCoreApplication::applicationPid() <<
+           ",\"args\":{\"name\":\"" << escapedName(QCoreApplication::applicationName().toUtf8().constData()) << "\"}}";
+
+    for (const auto& traceEvent : _traceEvents) {
+        out << ",\n{\"name\":\"" << escapedName(traceEvent.name) << "\",\"ph\":\"" << traceEvent.phase <<
+               "\",\"pid\":" << QCoreApplication::applicationPid() << ",\"tid\":" << traceEvent.threadId <<
+               ",\"ts\":" << QString::number(traceEvent.startNs / 1e3, 'f', 3);
+
+        if (traceEvent.phase == 'X')
+            out << ",\"dur\":" << QString::number(traceEvent.value / 1e3, 'f', 3) << '}';
+        else
+            out << ",\"args\":{\"value\":" << traceEvent.value << "}}";
+    }
+
+    out << "\n]}\n";
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+void Profiler::Reset() {
+    QMutexLocker locker(&_mutex);
+    _timers.clear();
+    _counters.clear();
+    _traceEvents.clear();
+    _droppedTraceEvents = 0;
+}
+
+const char* Profiler::CanonicalName(const char* name) {
+    const auto canonicalNameIt = _canonicalNames.constFind(name);
+
+    if (canonicalNameIt != _canonicalNames.cend())
+        return canonicalNameIt.value();
+
+    const char* canonicalName = _internedNames.value(QByteArray::fromRawData(name, static_cast<int>(qstrlen(name))));
+
+    if (!canonicalName) {
+        canonicalName = name;
+        _internedNames.insert(QByteArray(name), name);
+    }
+
+    _canonicalNames.insert(name, canonicalName);
+    return canonicalName;
+}
+
+void Profiler::AppendTraceEvent(const TraceEvent& traceEvent) {
+    // Буфер трассировки ограничен, чтобы долгая сессия не съедала память; отброшенные события учитываются
+    if (_traceEvents.size() < _maxTraceEvents)
+        _traceEvents.append(traceEvent);
+    else
+        ++_droppedTraceEvents;
+}
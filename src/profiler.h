@@ -0,0 +1,117 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+
+// Лёгкий профилировщик горячих участков: таймеры областей видимости и счётчики.
+// В выключенном состоянии каждая точка замера стоит одного атомарного чтения, а при сборке
+// с FRAMEMODEL_NO_PROFILING макросы PROFILE_SCOPE и PROFILE_COUNTER не генерируют кода вовсе
+class Profiler {
+public:
+    struct TimerStats {
+        const char* name;
+        qint64 count;
+        double lastMs, p50Ms, p99Ms, totalMs;
+    };
+
+    struct CounterStats {
+        const char* name;
+        qint64 count, value;
+    };
+
+    static Profiler& Instance();
+
+    bool IsEnabled() const {
+        return _isEnabled.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool isEnabled);
+    qint64 NowNs() const;
+    // name — строковый литерал: записи различаются по содержимому имени, а не по адресу
+    void RecordScope(const char* name, qint64 startNs, qint64 durationNs);
+    void RecordCounter(const char* name, qint64 value);
+    QVector<TimerStats> GetTimerStats() const;
+    QVector<CounterStats> GetCounterStats() const;
+    bool SaveChromeTrace(const QString& filePath) const;
+    void Reset();
+
+private:
+    struct Timer {
+        qint64 count = 0, lastNs = 0, totalNs = 0;
+        QVector<qint64> recentNs; // Кольцевой буфер последних замеров для p50/p99
+        int nextRecent = 0;
+    };
+
+    struct Counter {
+        qint64 count = 0, value = 0;
+    };
+
+    // Событие в формате Chrome trace-event: 'X' — завершённая область, 'C' — значение счётчика
+    struct TraceEvent {
+        const char* name;
+        char phase;
+        qint64 startNs;
+        qint64 value; // Длительность в наносекундах для 'X', значение счётчика для 'C'
+        quintptr threadId;
+    };
+
+    std::atomic_bool _isEnabled{false};
+    QElapsedTimer _clock;
+    mutable QMutex _mutex;
+    // Ключи — канонические адреса имён, поэтому поиск не требует сравнения строк. Одинаковые литералы
+    // из разных единиц трансляции могут иметь разные адреса: каждый адрес один раз сводится к адресу
+    // первого встреченного имени с тем же содержимым
+    QHash<const char*, Timer> _timers;
+    QHash<const char*, Counter> _counters;
+    QHash<const char*, const char*> _canonicalNames; // [адрес имени, канонический адрес]
+    QHash<QByteArray, const char*> _internedNames; // [имя, канонический адрес]
+    QVector<TraceEvent> _traceEvents;
+    qint64 _droppedTraceEvents = 0;
+
+    inline static constexpr int _recentSamplesCount = 1024;
+    inline static constexpr int _maxTraceEvents = 1 << 20;
+
+    Profiler();
+    const char* CanonicalName(const char* name);
+    void AppendTraceEvent(const TraceEvent& traceEvent);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : _name(Profiler::Instance().IsEnabled() ? name : nullptr) {
+        if (_name)
+            _startNs = Profiler::Instance().NowNs();
+    }
+
+    ~ProfileScope() {
+        if (_name) {
+            auto& profiler = Profiler::Instance();
+            profiler.RecordScope(_name, _startNs, profiler.NowNs() - _startNs);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* _name;
+    qint64 _startNs = 0;
+};
+
+#ifdef FRAMEMODEL_NO_PROFILING
+    #define PROFILE_SCOPE(name)
+    #define PROFILE_COUNTER(name, value)
+#else
+    #define PROFILE_CONCAT_IMPL(left, right) left##right
+    #define PROFILE_CONCAT(left, right) PROFILE_CONCAT_IMPL(left, right)
+    #define PROFILE_SCOPE(name) const ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+    #define PROFILE_COUNTER(name, value) \
+        do { if (Profiler::Instance().IsEnabled()) Profiler::Instance().RecordCounter(name, value); } while (false)
+#endif
+
+#endif // PROFILER_H
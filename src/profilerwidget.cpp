@@ -0,0 +1,100 @@
+#include "profilerwidget.h"
+#include "profiler.h"
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+ProfilerWidget::ProfilerWidget(QWidget* parent) : QWidget(parent), _isEnabledCheckBox(new QCheckBox("Профилирование включено", this)),
+    _statsTable(new QTableWidget(0, 5, this))
+{
+    auto* resetButton = new QPushButton("Сбросить", this);
+    auto* saveTraceButton = new QPushButton("Сохранить трассировку...", this);
+
+    auto* controlsLayout = new QHBoxLayout;
+    controlsLayout->addWidget(_isEnabledCheckBox);
+    controlsLayout->addStretch();
+    controlsLayout->addWidget(resetButton);
+    controlsLayout->addWidget(saveTraceButton);
+
+    auto* layout = new QVBoxLayout(this);
+    layout->addLayout(controlsLayout);
+    layout->addWidget(_statsTable);
+
+    _statsTable->setHorizontalHeaderLabels({"Участок", "Вызовов", "Последний, мс", "p50, мс", "p99, мс"});
+    _statsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    _statsTable->verticalHeader()->hide();
+    _statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    _isEnabledCheckBox->setChecked(Profiler::Instance().IsEnabled());
+    _refreshTimer.setInterval(500);
+
+    connect(_isEnabledCheckBox, &QCheckBox::toggled, this, [](bool isChecked) {
+        Profiler::Instance().SetEnabled(isChecked);
+    });
+
+    connect(resetButton, &QPushButton::clicked, this, [=]() {
+        Profiler::Instance().Reset();
+        Refresh();
+    });
+
+    connect(saveTraceButton, &QPushButton::clicked, this, &ProfilerWidget::SaveChromeTrace);
+    connect(&_refreshTimer, &QTimer::timeout, this, &ProfilerWidget::Refresh);
+}
+
+void ProfilerWidget::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    Refresh();
+    _refreshTimer.start();
+}
+
+void ProfilerWidget::hideEvent(QHideEvent* event) {
+    _refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+void ProfilerWidget::Refresh() {
+    const auto timerStats = Profiler::Instance().GetTimerStats();
+    const auto counterStats = Profiler::Instance().GetCounterStats();
+
+    _statsTable->setRowCount(timerStats.size() + counterStats.size());
+
+    auto setRow = [this](int row, const QStringList& columns) {
+        for (int column = 0; column < columns.size(); ++column) {
+            auto* item = _statsTable->item(row, column);
+
+            if (!item) {
+                item = new QTableWidgetItem;
+                _statsTable->setItem(row, column, item);
+            }
+
+            item->setText(columns[column]);
+        }
+    };
+
+    int row = 0;
+
+    for (const auto& timer : timerStats) {
+        setRow(row++, {timer.name, QString::number(timer.count), QString::number(timer.lastMs, 'f', 3),
+                       QString::number(timer.p50Ms, 'f', 3), QString::number(timer.p99Ms, 'f', 3)});
+    }
+
+    // Для счётчиков в столбце "Последний" выводится последнее записанное значение
+    for (const auto& counter : counterStats) {
+        setRow(row++, {counter.name, QString::number(counter.count), QString::number(counter.value), "", ""});
+    }
+}
+
+void ProfilerWidget::SaveChromeTrace() {
+    const auto filePath = QFileDialog::getSaveFileName(this, "Сохранение трассировки", "trace.json", "Chrome trace (*.json)");
+
+    if (filePath.isEmpty())
+        return;
+
+    if (!Profiler::Instance().SaveChromeTrace(filePath))
+        QMessageBox::critical(nullptr, "Ошибка при сохранении трассировки", "Не удалось записать файл \"" + filePath + "\"");
+}
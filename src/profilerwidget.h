@@ -0,0 +1,31 @@
+#ifndef PROFILERWIDGET_H
+#define PROFILERWIDGET_H
+
+#include <QTimer>
+#include <QWidget>
+
+class QCheckBox;
+class QTableWidget;
+
+// Панель с показателями профилировщика: последнее время, p50/p99 и число вызовов для таймеров
+// и последние значения счётчиков. Обновляется по таймеру, только пока панель видна
+class ProfilerWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ProfilerWidget(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    QCheckBox* _isEnabledCheckBox;
+    QTableWidget* _statsTable;
+    QTimer _refreshTimer;
+
+    void Refresh();
+    void SaveChromeTrace();
+};
+
+#endif // PROFILERWIDGET_H
@@ -0,0 +1,266 @@
+#include "slotstringpool.h"
+#include "frame.h"
+#include "memoryusage.h"
+#include "profiler.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLOTSTRINGPOOL_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC и Clang компилируют код AVX2 только в функциях, явно помеченных этим расширением
+#if defined(__GNUC__)
+#define SLOTSTRINGPOOL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SLOTSTRINGPOOL_TARGET_AVX2
+#endif
+
+namespace {
+    // Позиция первого вхождения pattern в text не раньше from или -1
+    using FindKernel = int (*)(const ushort* text, int textSize, int from, const ushort* pattern, int patternSize);
+
+    struct Kernel {
+        FindKernel find;
+        const char* name;
+    };
+
+    // Первый символ кандидата уже совпал, сравниваются остальные
+    bool IsMatchAt(const ushort* text, const ushort* pattern, int patternSize) {
+        return std::memcmp(text + 1, pattern + 1, static_cast<size_t>(patternSize - 1) * sizeof(ushort)) == 0;
+    }
+
+    int FindScalar(const ushort* text, int textSize, int from, const ushort* pattern, int patternSize) {
+        const ushort firstChar = pattern[0];
+
+        for (int position = from; position <= textSize - patternSize; ++position) {
+            if (text[position] == firstChar && IsMatchAt(text + position, pattern, patternSize))
+                return position;
+        }
+
+        return -1;
+    }
+
+#ifdef SLOTSTRINGPOOL_X86_SIMD
+    // Ядра сравнивают блок текста с первым символом образца, а блок, сдвинутый на длину образца, — с последним.
+    // Полное сравнение нужно только там, где совпали оба, что на обычном тексте случается редко.
+    // На каждый 16-битный символ в маске _mm_movemask_epi8 приходится два бита
+    int FindSse2(const ushort* text, int textSize, int from, const ushort* pattern, int patternSize) {
+        constexpr int lanesCount = 8;
+        const auto firstChars = _mm_set1_epi16(static_cast<short>(pattern[0]));
+        const auto lastChars = _mm_set1_epi16(static_cast<short>(pattern[patternSize - 1]));
+        int position = from;
+
+        for (; position <= textSize - patternSize - lanesCount + 1; position += lanesCount) {
+            const auto firstBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+            const auto lastBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position + patternSize - 1));
+            auto mask = static_cast<uint>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(firstBlock, firstChars),
+                                                                          _mm_cmpeq_epi16(lastBlock, lastChars))));
+
+            while (mask) {
+                const int lane = static_cast<int>(qCountTrailingZeroBits(mask)) / 2;
+
+                if (IsMatchAt(text + position + lane, pattern, patternSize))
+                    return position + lane;
+
+                mask &= ~(3u << (lane * 2));
+            }
+        }
+
+        return FindScalar(text, textSize, position, pattern, patternSize);
+    }
+
+    SLOTSTRINGPOOL_TARGET_AVX2
+    int FindAvx2(const ushort* text, int textSize, int from, const ushort* pattern, int patternSize) {
+        constexpr int lanesCount = 16;
+        const auto firstChars = _mm256_set1_epi16(static_cast<short>(pattern[0]));
+        const auto lastChars = _mm256_set1_epi16(static_cast<short>(pattern[patternSize - 1]));
+        int position = from;
+
+        for (; position <= textSize - patternSize - lanesCount + 1; position += lanesCount) {
+            const auto firstBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position));
+            const auto lastBlock = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position + patternSize - 1));
+            auto mask = static_cast<uint>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(firstBlock, firstChars),
+                                                                                _mm256_cmpeq_epi16(lastBlock, lastChars))));
+
+            while (mask) {
+                const int lane = static_cast<int>(qCountTrailingZeroBits(mask)) / 2;
+
+                if (IsMatchAt(text + position + lane, pattern, patternSize))
+                    return position + lane;
+
+                mask &= ~(3u << (lane * 2));
+            }
+        }
+
+        return FindScalar(text, textSize, position, pattern, patternSize);
+    }
+
+    bool HasAvx2() {
+#if defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+
+        if (cpuInfo[0] < 7)
+            return false;
+
+        // Регистры AVX должна сохранять и операционная система
+        __cpuid(cpuInfo, 1);
+        const bool isAvxEnabled = (cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+
+        __cpuidex(cpuInfo, 7, 0);
+        return isAvxEnabled && (cpuInfo[1] & (1 << 5));
+#else
+        return false;
+#endif
+    }
+#endif
+
+    // Переменная окружения FRAMEMODEL_SIMD=sse2|scalar ограничивает выбор ядра, чтобы сравнить их скорость
+    Kernel ChooseKernel() {
+        const auto requestedKernel = qgetenv("FRAMEMODEL_SIMD").toLower();
+
+#ifdef SLOTSTRINGPOOL_X86_SIMD
+        if (requestedKernel != "scalar" && requestedKernel != "sse2" && HasAvx2())
+            return {FindAvx2, "AVX2"};
+
+        if (requestedKernel != "scalar")
+            return {FindSse2, "SSE2"};
+#endif
+
+        return {FindScalar, "скалярное"};
+    }
+
+    const Kernel& GetKernel() {
+        static const Kernel kernel = ChooseKernel();
+        return kernel;
+    }
+
+    // Простая свёртка регистра по одному символу UTF-16: длина строки не меняется, поэтому смещения строк
+    // в свёрнутой копии пула совпадают со смещениями в исходной
+    void FoldCase(QString& text, int from) {
+        for (auto charIt = text.begin() + from; charIt != text.end(); ++charIt) {
+            *charIt = charIt->toCaseFolded();
+        }
+    }
+}
+
+void SlotStringPool::Clear() {
+    _text.clear();
+    _foldedText.clear();
+    _stringOffsets.clear();
+    _stringSlotIndices.clear();
+    _slotLocations.clear();
+    _frameNames.clear();
+}
+
+void SlotStringPool::Append(const Frame& frame) {
+    const int frameIndex = _frameNames.size();
+    _frameNames.append(frame.GetName());
+
+    for (const auto& [slotName, slotValueVariant] : frame.GetSlots()) {
+        const int slotIndex = _slotLocations.size();
+        const bool isFrameReference = std::holds_alternative<FrameHandle>(slotValueVariant);
+
+        _slotLocations.append({frameIndex, _stringOffsets.size(), isFrameReference});
+        AppendString(slotName, slotIndex);
+
+        if (!isFrameReference)
+            AppendString(std::get<QString>(slotValueVariant), slotIndex);
+    }
+}
+
+int SlotStringPool::GetFramesCount() const {
+    return _frameNames.size();
+}
+
+int SlotStringPool::GetSlotsCount() const {
+    return _slotLocations.size();
+}
+
+qint64 SlotStringPool::GetTextBytes() const {
+    return static_cast<qint64>(_text.size()) * sizeof(QChar);
+}
+
+qint64 SlotStringPool::GetBytes() const {
+    return MemoryUsage::GetStringDataBytes(_text) + MemoryUsage::GetStringDataBytes(_foldedText) +
+           static_cast<qint64>(_stringOffsets.capacity() + _stringSlotIndices.capacity()) * sizeof(int) +
+           static_cast<qint64>(_slotLocations.capacity()) * sizeof(SlotLocation) +
+           static_cast<qint64>(_frameNames.capacity()) * sizeof(QString);
+}
+
+void SlotStringPool::Search(const QString& substring, Qt::CaseSensitivity caseSensitivity, const std::function<void(const SlotLocation&)>& callback) const {
+    PROFILE_SCOPE("SlotStringPool::Search");
+
+    if (substring.isEmpty() || substring.contains(QChar(0)))
+        return;
+
+    const bool isCaseSensitive = caseSensitivity == Qt::CaseSensitive;
+    auto pattern = substring;
+
+    if (!isCaseSensitive)
+        FoldCase(pattern, 0);
+
+    const auto& text = isCaseSensitive ? _text : _foldedText;
+    const auto* textData = reinterpret_cast<const ushort*>(text.constData());
+    const auto* patternData = reinterpret_cast<const ushort*>(pattern.constData());
+    const auto find = GetKernel().find;
+    int position = 0;
+
+    while ((position = find(textData, text.size(), position, patternData, pattern.size())) >= 0) {
+        const int stringIndex = static_cast<int>(std::upper_bound(_stringOffsets.cbegin(), _stringOffsets.cend(), position) - _stringOffsets.cbegin()) - 1;
+        const auto& slotLocation = _slotLocations[_stringSlotIndices[stringIndex]];
+
+        callback(slotLocation);
+
+        // Поиск продолжается со строки, следующей за строками найденного слота, чтобы не сообщать о нём дважды
+        const int nextStringIndex = slotLocation.nameStringIndex + (slotLocation.isFrameReference ? 1 : 2);
+
+        if (nextStringIndex >= _stringOffsets.size())
+            break;
+
+        position = _stringOffsets[nextStringIndex];
+    }
+}
+
+const QString& SlotStringPool::GetFrameName(const SlotLocation& slotLocation) const {
+    return _frameNames[slotLocation.frameIndex];
+}
+
+SlotTable::Slot SlotStringPool::GetSlot(const SlotLocation& slotLocation) const {
+    if (slotLocation.isFrameReference)
+        return {GetString(slotLocation.nameStringIndex), FrameHandle()};
+
+    return {GetString(slotLocation.nameStringIndex), GetString(slotLocation.nameStringIndex + 1)};
+}
+
+QString SlotStringPool::GetKernelName() {
+    return GetKernel().name;
+}
+
+void SlotStringPool::AppendString(const QString& string, int slotIndex) {
+    _stringOffsets.append(_text.size());
+    _stringSlotIndices.append(slotIndex);
+
+    _text += string;
+    _text += QChar(0);
+
+    const int foldedStringOffset = _foldedText.size();
+    _foldedText += string;
+    FoldCase(_foldedText, foldedStringOffset);
+    _foldedText += QChar(0);
+}
+
+QString SlotStringPool::GetString(int stringIndex) const {
+    const int stringOffset = _stringOffsets[stringIndex];
+    const int nextStringOffset = stringIndex + 1 < _stringOffsets.size() ? _stringOffsets[stringIndex + 1] : _text.size();
+    return QString(_text.constData() + stringOffset, nextStringOffset - stringOffset - 1);
+}
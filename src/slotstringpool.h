@@ -0,0 +1,51 @@
+#ifndef SLOTSTRINGPOOL_H
+#define SLOTSTRINGPOOL_H
+
+#include "slottable.h"
+#include <functional>
+
+class Frame;
+
+// Имена и значения всех слотов модели, уложенные подряд в один массив UTF-16 через нулевой символ,
+// и копия этого массива со свёрнутым регистром. Поиск подстроки, который не покрывает ни один индекс,
+// идёт одним проходом по непрерывной памяти вместо обхода фреймов и разрозненных QString: ядро AVX2
+// или SSE2 отбирает позиции, где совпадают первый и последний символы образца, и только их сравнивает
+// целиком, а без этих расширений работает скалярный код. Нулевой символ не входит в образец,
+// поэтому совпадение не переходит через границу строк
+class SlotStringPool {
+public:
+    // Слот, которому принадлежат строки пула: его имя и следующая за ним строка со значением
+    // (у слота-фрейма значения нет, его имя совпадает с именем фрейма, на который он ссылается)
+    struct SlotLocation {
+        int frameIndex; // В порядке добавления фреймов в пул
+        int nameStringIndex;
+        bool isFrameReference;
+    };
+
+    void Clear();
+    void Append(const Frame& frame);
+    int GetFramesCount() const;
+    int GetSlotsCount() const;
+    qint64 GetTextBytes() const;
+    qint64 GetBytes() const;
+    // callback(const SlotLocation&) для каждого слота, имя или значение которого содержит substring,
+    // в порядке добавления в пул. Пустая подстрока ничего не находит
+    void Search(const QString& substring, Qt::CaseSensitivity caseSensitivity, const std::function<void(const SlotLocation&)>& callback) const;
+    const QString& GetFrameName(const SlotLocation& slotLocation) const;
+    SlotTable::Slot GetSlot(const SlotLocation& slotLocation) const;
+
+    // Ядро поиска, выбранное для этого процессора: "AVX2", "SSE2" или "скалярное"
+    static QString GetKernelName();
+
+private:
+    QString _text, _foldedText;
+    QVector<int> _stringOffsets; // Начало каждой строки в _text
+    QVector<int> _stringSlotIndices; // [StringIndex, индекс слота в _slotLocations]
+    QVector<SlotLocation> _slotLocations;
+    QVector<QString> _frameNames;
+
+    void AppendString(const QString& string, int slotIndex);
+    QString GetString(int stringIndex) const;
+};
+
+#endif // SLOTSTRINGPOOL_H
@@ -0,0 +1,160 @@
+#include "slottable.h"
+#include <QHash>
+#include <stdexcept>
+
+SlotTable::iterator SlotTable::begin() {
+    return _slots.begin();
+}
+
+SlotTable::iterator SlotTable::end() {
+    return _slots.end();
+}
+
+SlotTable::const_iterator SlotTable::begin() const {
+    return _slots.cbegin();
+}
+
+SlotTable::const_iterator SlotTable::end() const {
+    return _slots.cend();
+}
+
+int SlotTable::Size() const {
+    return _slots.size();
+}
+
+bool SlotTable::IsEmpty() const {
+    return _slots.isEmpty();
+}
+
+SlotTable::iterator SlotTable::Find(const QString& slotName) {
+    const int slotIndex = IndexOf(slotName);
+    return slotIndex < 0 ? end() : begin() + slotIndex;
+}
+
+SlotTable::const_iterator SlotTable::Find(const QString& slotName) const {
+    const int slotIndex = IndexOf(slotName);
+    return slotIndex < 0 ? end() : begin() + slotIndex;
+}
+
+SlotTable::Value& SlotTable::At(const QString& slotName) {
+    const int slotIndex = IndexOf(slotName);
+
+    if (slotIndex < 0)
+        throw std::out_of_range("SlotTable::At");
+
+    return _slots[slotIndex].value;
+}
+
+const SlotTable::Value& SlotTable::At(const QString& slotName) const {
+    const int slotIndex = IndexOf(slotName);
+
+    if (slotIndex < 0)
+        throw std::out_of_range("SlotTable::At");
+
+    return _slots[slotIndex].value;
+}
+
+void SlotTable::InsertOrAssign(QString slotName, Value slotValue) {
+    const int slotIndex = IndexOf(slotName);
+
+    if (slotIndex >= 0) {
+        _slots[slotIndex].value = std::move(slotValue);
+        return;
+    }
+
+    _slots.append({std::move(slotName), std::move(slotValue)});
+
+    if (_slots.size() <= _linearScanLimit)
+        return;
+
+    // Заполненность таблицы индексов держится не выше половины, чтобы цепочки проб оставались короткими
+    if (_index.size() < _slots.size() * 2)
+        RebuildIndex();
+    else
+        InsertIntoIndex(_slots.size() - 1);
+}
+
+bool SlotTable::Erase(const QString& slotName) {
+    const int slotIndex = IndexOf(slotName);
+
+    if (slotIndex < 0)
+        return false;
+
+    // Удаление сохраняет порядок остальных слотов, поэтому индексы после удалённого сдвигаются
+    _slots.remove(slotIndex);
+    RebuildIndex();
+    return true;
+}
+
+void SlotTable::Rename(const QString& oldSlotName, QString newSlotName) {
+    const int slotIndex = IndexOf(oldSlotName);
+
+    if (slotIndex < 0)
+        throw std::out_of_range("SlotTable::Rename");
+
+    // Два слота с одним именем разошлись бы в IndexOf и индексе
+    const int newSlotIndex = IndexOf(newSlotName);
+
+    if (newSlotIndex >= 0 && newSlotIndex != slotIndex)
+        throw std::invalid_argument("SlotTable::Rename");
+
+    _slots[slotIndex].name = std::move(newSlotName);
+    RebuildIndex();
+}
+
+qint64 SlotTable::GetSlotsBytes() const {
+    return static_cast<qint64>(_slots.capacity()) * sizeof(Slot);
+}
+
+qint64 SlotTable::GetIndexBytes() const {
+    return static_cast<qint64>(_index.capacity()) * sizeof(int);
+}
+
+int SlotTable::IndexOf(const QString& slotName) const {
+    if (_index.isEmpty()) {
+        for (int slotIndex = 0; slotIndex < _slots.size(); ++slotIndex) {
+            if (_slots[slotIndex].name == slotName)
+                return slotIndex;
+        }
+
+        return -1;
+    }
+
+    const int mask = _index.size() - 1;
+
+    for (int bucket = qHash(slotName) & mask; _index[bucket] >= 0; bucket = (bucket + 1) & mask) {
+        if (_slots[_index[bucket]].name == slotName)
+            return _index[bucket];
+    }
+
+    return -1;
+}
+
+void SlotTable::RebuildIndex() {
+    if (_slots.size() <= _linearScanLimit) {
+        _index.clear();
+        _index.squeeze();
+        return;
+    }
+
+    int indexSize = 16;
+
+    while (indexSize < _slots.size() * 2)
+        indexSize *= 2;
+
+    _index.fill(-1, indexSize);
+
+    for (int slotIndex = 0; slotIndex < _slots.size(); ++slotIndex) {
+        InsertIntoIndex(slotIndex);
+    }
+}
+
+void SlotTable::InsertIntoIndex(int slotIndex) {
+    const int mask = _index.size() - 1;
+    int bucket = qHash(_slots[slotIndex].name) & mask;
+
+    while (_index[bucket] >= 0)
+        bucket = (bucket + 1) & mask;
+
+    _index[bucket] = slotIndex;
+}
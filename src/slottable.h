@@ -0,0 +1,53 @@
+#ifndef SLOTTABLE_H
+#define SLOTTABLE_H
+
+#include "framehandle.h"
+#include <QString>
+#include <QVector>
+#include <variant>
+
+// Компактное хранилище слотов фрейма: записи лежат подряд в одном массиве в порядке добавления.
+// Пока слотов немного, поиск идёт линейным проходом, а для крупных фреймов дополнительно строится
+// плоская хеш-таблица с открытой адресацией, хранящая только индексы записей
+class SlotTable {
+public:
+    // Обычный слот (его значение) / слот-фрейм (ссылка на фрейм, имя которого совпадает с именем слота)
+    using Value = std::variant<QString, FrameHandle>;
+
+    struct Slot {
+        QString name;
+        Value value;
+    };
+
+    using iterator = QVector<Slot>::iterator;
+    using const_iterator = QVector<Slot>::const_iterator;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    int Size() const;
+    bool IsEmpty() const;
+    iterator Find(const QString& slotName);
+    const_iterator Find(const QString& slotName) const;
+    Value& At(const QString& slotName);
+    const Value& At(const QString& slotName) const;
+    void InsertOrAssign(QString slotName, Value slotValue);
+    bool Erase(const QString& slotName);
+    void Rename(const QString& oldSlotName, QString newSlotName);
+    qint64 GetSlotsBytes() const;
+    qint64 GetIndexBytes() const;
+
+private:
+    QVector<Slot> _slots;
+    QVector<int> _index; // Пуст, пока слотов не больше _linearScanLimit; -1 — свободная ячейка
+
+    inline static constexpr int _linearScanLimit = 8;
+
+    int IndexOf(const QString& slotName) const;
+    void RebuildIndex();
+    void InsertIntoIndex(int slotIndex);
+};
+
+#endif // SLOTTABLE_H
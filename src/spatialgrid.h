@@ -0,0 +1,206 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include "memoryusage.h"
+#include <QLine>
+#include <QRect>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+// Равномерная сетка для быстрого поиска прямоугольников, пересекающих заданную область.
+// Каждый прямоугольник регистрируется во всех ячейках, которые он покрывает, поэтому
+// запрос затрагивает только ячейки внутри области запроса, а не все объекты модели.
+// Отрезок (стрелка) регистрируется только в ячейках вдоль себя, а не во всём описанном прямоугольнике:
+// иначе длинная диагональ занимала бы на холсте 10000×10000 до полутора тысяч ячеек
+template <typename Key>
+class SpatialGrid {
+public:
+    explicit SpatialGrid(int cellSize = 256) : _cellSize(cellSize)
+    {
+    }
+
+    // Если ключ уже есть в сетке, его прямоугольник заменяется
+    void Insert(const Key& key, const QRect& rect) {
+        Remove(key);
+        _rects.insert(key, rect);
+        ForEachCell(rect, [&](quint64 cellKey) { _cells[cellKey].append(key); });
+    }
+
+    // Отрезок толщиной 2 * margin. Rect(key) для него — описанный прямоугольник с тем же запасом
+    void InsertLine(const Key& key, const QLine& line, int margin) {
+        Remove(key);
+        _rects.insert(key, QRect(line.p1(), line.p2()).normalized().adjusted(-margin, -margin, margin, margin));
+        _lines.insert(key, {line, margin});
+        ForEachLineCell(line, margin, [&](quint64 cellKey) { _cells[cellKey].append(key); });
+    }
+
+    void Remove(const Key& key) {
+        const auto rectIt = _rects.constFind(key);
+
+        if (rectIt == _rects.constEnd())
+            return;
+
+        const auto removeFromCell = [&](quint64 cellKey) {
+            auto cellIt = _cells.find(cellKey);
+            auto& cell = cellIt.value();
+            const int keyIndex = cell.indexOf(key);
+
+            // Порядок внутри ячейки не важен, поэтому удаление обменом с последним элементом
+            cell[keyIndex] = cell.last();
+            cell.removeLast();
+
+            if (cell.isEmpty())
+                _cells.erase(cellIt);
+        };
+
+        const auto lineIt = _lines.constFind(key);
+
+        if (lineIt != _lines.constEnd()) {
+            ForEachLineCell(lineIt->line, lineIt->margin, removeFromCell);
+            _lines.erase(lineIt);
+        }
+        else {
+            ForEachCell(rectIt.value(), removeFromCell);
+        }
+
+        _rects.remove(key);
+    }
+
+    void Clear() {
+        _cells.clear();
+        _rects.clear();
+        _lines.clear();
+    }
+
+    bool Contains(const Key& key) const {
+        return _rects.contains(key);
+    }
+
+    QRect Rect(const Key& key) const {
+        return _rects.value(key);
+    }
+
+    int Size() const {
+        return _rects.size();
+    }
+
+    qint64 GetBytes() const {
+        qint64 cellsBytes = MemoryUsage::GetHashBytes(_cells);
+
+        for (const auto& cell : _cells) {
+            cellsBytes += static_cast<qint64>(cell.capacity()) * sizeof(Key);
+        }
+
+        return cellsBytes + MemoryUsage::GetHashBytes(_rects) + MemoryUsage::GetHashBytes(_lines);
+    }
+
+    // Все ключи, прямоугольники которых пересекают area. Каждый ключ возвращается ровно один раз:
+    // прямоугольник учитывается только в той ячейке, где находится левый верхний угол пересечения,
+    // а отрезок, которого в этой ячейке может не быть, — в первой встреченной. Отрезок возвращается,
+    // если в area попадает ячейка, через которую он проходит, то есть с точностью до ячейки
+    QVector<Key> Query(const QRect& area) const {
+        QVector<Key> result;
+        QSet<Key> foundLines;
+
+        if (area.isEmpty())
+            return result;
+
+        const int firstColumn = CellCoord(area.left()), lastColumn = CellCoord(area.right());
+        const int firstRow = CellCoord(area.top()), lastRow = CellCoord(area.bottom());
+
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                const auto cellIt = _cells.constFind(CellKey(column, row));
+
+                if (cellIt == _cells.constEnd())
+                    continue;
+
+                for (const auto& key : cellIt.value()) {
+                    const auto intersection = _rects.value(key).intersected(area);
+
+                    if (intersection.isEmpty())
+                        continue;
+
+                    if (_lines.contains(key)) {
+                        if (!foundLines.contains(key)) {
+                            foundLines.insert(key);
+                            result.append(key);
+                        }
+                    }
+                    else if (CellCoord(intersection.left()) == column && CellCoord(intersection.top()) == row) {
+                        result.append(key);
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+private:
+    struct Line {
+        QLine line;
+        int margin;
+    };
+
+    int _cellSize;
+    QHash<quint64, QVector<Key>> _cells;
+    QHash<Key, QRect> _rects;
+    QHash<Key, Line> _lines; // Ключи, зарегистрированные отрезком
+
+    int CellCoord(int coord) const {
+        // Деление с округлением вниз, чтобы отрицательные координаты не попадали в нулевую ячейку
+        return coord >= 0 ? coord / _cellSize : (coord - _cellSize + 1) / _cellSize;
+    }
+
+    static quint64 CellKey(int column, int row) {
+        return (quint64(quint32(column)) << 32) | quint32(row);
+    }
+
+    template <typename Callback>
+    void ForEachCell(const QRect& rect, Callback callback) const {
+        if (rect.isEmpty())
+            return;
+
+        for (int row = CellCoord(rect.top()); row <= CellCoord(rect.bottom()); ++row) {
+            for (int column = CellCoord(rect.left()); column <= CellCoord(rect.right()); ++column) {
+                callback(CellKey(column, row));
+            }
+        }
+    }
+
+    // Ячейки, через которые проходит отрезок с запасом margin: для каждого ряда ячеек берётся часть отрезка
+    // в полосе ряда (расширенной на margin) и покрываются столбцы её проекции на ось x, тоже с запасом
+    template <typename Callback>
+    void ForEachLineCell(const QLine& line, int margin, Callback callback) const {
+        const double x1 = line.x1(), y1 = line.y1(), dx = line.dx(), dy = line.dy();
+        const int firstRow = CellCoord(std::min(line.y1(), line.y2()) - margin);
+        const int lastRow = CellCoord(std::max(line.y1(), line.y2()) + margin);
+
+        for (int row = firstRow; row <= lastRow; ++row) {
+            double firstT = 0, lastT = 1;
+
+            if (dy != 0) {
+                const double bandTop = static_cast<double>(row) * _cellSize - margin;
+                const double bandBottom = static_cast<double>(row + 1) * _cellSize + margin;
+                firstT = std::max(0.0, std::min((bandTop - y1) / dy, (bandBottom - y1) / dy));
+                lastT = std::min(1.0, std::max((bandTop - y1) / dy, (bandBottom - y1) / dy));
+
+                if (firstT > lastT)
+                    continue;
+            }
+
+            const double firstX = x1 + dx * firstT, lastX = x1 + dx * lastT;
+            const int firstColumn = CellCoord(static_cast<int>(std::floor(std::min(firstX, lastX))) - margin);
+            const int lastColumn = CellCoord(static_cast<int>(std::ceil(std::max(firstX, lastX))) + margin);
+
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                callback(CellKey(column, row));
+            }
+        }
+    }
+};
+
+#endif // SPATIALGRID_H